@@ -50,11 +50,32 @@ class HPP_MANIPULATION_DLLAPI ConnectedComponent : public core::ConnectedCompone
       void addNode (const core::NodePtr_t& node);
 
       const RoadmapNodes_t& getRoadmapNodes (const graph::StatePtr_t graphState) const;
+
+      /// Get the configurations of the nodes in a graph state.
+      /// \return a matrix whose column i is the configuration of
+      ///         getRoadmapNodes(graphState)[i].
+      /// \note the configurations are copied when the nodes are added, so
+      ///       that the configurations of the nodes must not be modified.
+      matrixIn_t getConfigurations (const graph::StatePtr_t graphState) const;
+
+      /// Get the graph states containing nodes of this connected component.
+      const GraphStates_t& graphStates () const
+      {
+        return graphStateMap_;
+      }
      
   protected:
   private:
       bool check () const;
+      /// Add a node to graphStateMap_ and configurationMap_.
+      void addToState (const RoadmapNodePtr_t& node,
+          const graph::StatePtr_t& state);
+
 	GraphStates_t graphStateMap_;
+        /// Configurations of the nodes of each graph state, one per column.
+        /// The matrices have more columns than nodes to limit the number of
+        /// reallocations.
+        std::map <graph::StatePtr_t, matrix_t> configurationMap_;
 	// a RoadmapWkPtr_t so that memory can be released ?
 	RoadmapWkPtr_t roadmap_;
         static RoadmapNodes_t empty_;
@@ -40,6 +40,7 @@ namespace hpp {
     typedef core::ConfigurationPtr_t ConfigurationPtr_t;
     typedef pinocchio::GripperPtr_t GripperPtr_t;
     typedef pinocchio::LiegroupElement LiegroupElement;
+    typedef pinocchio::LiegroupElementConstRef LiegroupElementConstRef;
     typedef pinocchio::LiegroupSpace LiegroupSpace;
     typedef pinocchio::LiegroupSpacePtr_t LiegroupSpacePtr_t;
     HPP_PREDEF_CLASS (AxialHandle);
@@ -113,6 +114,12 @@ namespace hpp {
     typedef core::ConfigProjectorPtr_t ConfigProjectorPtr_t;
     HPP_PREDEF_CLASS (ConstraintSet);
     typedef shared_ptr <ConstraintSet> ConstraintSetPtr_t;
+    HPP_PREDEF_CLASS (ReversedPath);
+    typedef shared_ptr <ReversedPath> ReversedPathPtr_t;
+    HPP_PREDEF_CLASS (LazyPath);
+    typedef shared_ptr <LazyPath> LazyPathPtr_t;
+    HPP_PREDEF_CLASS (LazyPathCache);
+    typedef shared_ptr <LazyPathCache> LazyPathCachePtr_t;
     typedef core::DifferentiableFunctionPtr_t DifferentiableFunctionPtr_t;
     typedef core::ConfigurationShooter ConfigurationShooter;
     typedef core::ConfigurationShooterPtr_t ConfigurationShooterPtr_t;
@@ -17,6 +17,9 @@
 #ifndef HPP_MANIPULATION_GRAPH_EDGE_HH
 # define HPP_MANIPULATION_GRAPH_EDGE_HH
 
+#include <list>
+#include <mutex>
+
 #include <hpp/core/constraint-set.hh>
 #include <hpp/core/steering-method.hh>
 #include <hpp/core/relative-motion.hh>
@@ -206,6 +209,20 @@ namespace hpp {
           bool isShort () const {
             return isShort_;
           }
+
+          /// Whether the target constraints are solved by explicit
+          /// substitution only.
+          ///
+          /// This is computed at initialization. It is true when all the
+          /// constraints of the target constraint set are explicit and
+          /// were accepted by the explicit constraint set of the solver.
+          /// generateTargetConfig then evaluates the explicit constraints
+          /// directly instead of running the iterative solver.
+          bool isTargetExplicit () const
+          {
+            throwIfNotInitialized ();
+            return targetExplicit_;
+          }
 	   /// Constraint to project a path.
           /// \return The initialized constraint.
           ConstraintSetPtr_t pathConstraint() const;
@@ -241,6 +258,8 @@ namespace hpp {
           /// Constraint ensuring that a q_proj will be in to_ and in the
           /// same leaf of to_ as the configuration used for initialization.
           ConstraintSetPtr_t targetConstraints_;
+          /// See isTargetExplicit member function.
+          bool targetExplicit_;
 
           /// The two ends of the transition.
           StateWkPtr_t from_, to_;
@@ -336,6 +355,40 @@ namespace hpp {
           virtual bool generateTargetConfig (ConfigurationIn_t qStart,
                                              ConfigurationOut_t q) const;
 
+          /// Set the number of local restarts per waypoint.
+          ///
+          /// When generateTargetConfig fails at waypoint i, the waypoints
+          /// before i are kept and the projection of waypoint i is restarted
+          /// from a random configuration, up to this number of times,
+          /// before giving up. Default is 0.
+          void nbLocalRestarts (size_type number)
+          {
+            assert (number >= 0);
+            nbLocalRestarts_ = number;
+          }
+
+          size_type nbLocalRestarts () const
+          {
+            return nbLocalRestarts_;
+          }
+
+          /// Build the paths along the internal edges concurrently.
+          ///
+          /// Once the waypoints are computed, each internal edge builds its
+          /// path in a separate thread. The paths are then concatenated in
+          /// order. This requires the steering methods and constraints of
+          /// the internal edges to be usable from several threads.
+          /// Default is false.
+          void parallelBuild (bool enable)
+          {
+            parallelBuild_ = enable;
+          }
+
+          bool parallelBuild () const
+          {
+            return parallelBuild_;
+          }
+
           /// Return the index-th edge.
           const EdgePtr_t& waypoint (const std::size_t index) const;
 
@@ -354,10 +407,49 @@ namespace hpp {
           /// \param wTo is the destination state of wEdge
           void setWaypoint (const std::size_t index, const EdgePtr_t wEdge, const StatePtr_t wTo);
 
+          /// \name Waypoint cache
+          ///
+          /// The waypoints computed by generateTargetConfig and build are
+          /// stored in a cache of least recently used entries, indexed by
+          /// the start and end configurations. A call to build with the
+          /// same configurations starts from the cached waypoints.
+          /// The cache is protected by a mutex.
+          /// \{
+
+          /// Set the maximal number of entries of the cache.
+          /// 0 disables the cache.
+          void waypointCacheSize (std::size_t size);
+
+          std::size_t waypointCacheSize () const
+          {
+            return cacheSize_;
+          }
+
+          /// Number of calls to build that found their waypoints in the cache.
+          std::size_t nbCacheHits () const
+          {
+            std::lock_guard<std::mutex> lock (cacheMutex_);
+            return nbHits_;
+          }
+
+          /// Number of calls to build that did not find their waypoints in
+          /// the cache.
+          std::size_t nbCacheMisses () const
+          {
+            std::lock_guard<std::mutex> lock (cacheMutex_);
+            return nbMisses_;
+          }
+
+          /// Empty the cache and reset the counters.
+          void clearWaypointCache () const;
+
+          /// \}
+
         protected:
 	  WaypointEdge (const std::string& name) :
 	    Edge (name),
-            lastSucceeded_ (false)
+            nbLocalRestarts_ (0), parallelBuild_ (false),
+            cacheSize_ (16), nbHits_ (0), nbMisses_ (0)
 	    {
 	    }
           /// Initialization of the object.
@@ -370,11 +462,28 @@ namespace hpp {
           virtual std::ostream& print (std::ostream& os) const;
 
         private:
+          /// Copy the cached waypoints between q1 and q2 into configs.
+          /// \return whether the cache contains such waypoints.
+          bool retrieveWaypoints (ConfigurationIn_t q1, ConfigurationIn_t q2,
+              matrix_t& configs) const;
+          /// Insert configs in the cache.
+          void storeWaypoints (const matrix_t& configs) const;
+
           Edges_t edges_;
           States_t states_;
-
-          mutable matrix_t configs_;
-          mutable bool lastSucceeded_;
+          size_type nbLocalRestarts_;
+          bool parallelBuild_;
+
+          struct CachedWaypoints {
+            std::size_t key;
+            matrix_t configs;
+          };
+          typedef std::list<CachedWaypoints> WaypointCache_t;
+          /// Most recently used entries first.
+          mutable WaypointCache_t cache_;
+          std::size_t cacheSize_;
+          mutable std::size_t nbHits_, nbMisses_;
+          mutable std::mutex cacheMutex_;
 
           WaypointEdgeWkPtr_t wkPtr_;
       }; // class WaypointEdge
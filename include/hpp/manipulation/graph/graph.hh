@@ -81,6 +81,17 @@ namespace hpp {
           /// Select randomly outgoing edge of the given node.
           EdgePtr_t chooseEdge(RoadmapNodePtr_t node) const;
 
+          /// Number of transitions from each state to a given state.
+          typedef std::map <StatePtr_t, size_type> StateDistances_t;
+
+          /// Compute the number of transitions from each state to a target.
+          ///
+          /// Only the edges of positive weight are followed. A waypoint edge
+          /// counts as many transitions as it contains.
+          /// \return the distances of the states from which the target can
+          ///         be reached.
+          StateDistances_t distancesToState (const StatePtr_t& target) const;
+
           /// Clear the vector of constraints and complements
           /// \sa registerConstraints
           void clearConstraintsAndComplement();
@@ -227,6 +238,26 @@ namespace hpp {
             hists_.push_back (hist);
           }
 
+          /// Register the histogram of the foliation defined by the given
+          /// condition and parametrizer constraints.
+          ///
+          /// The histogram is also inserted in \ref histograms.
+          /// \sa leafHistogram
+          void insertHistogram (const LeafHistogramPtr_t& hist,
+              const NumericalConstraints_t& condition,
+              const NumericalConstraints_t& parametrizer);
+
+          /// Get the histogram of the foliation defined by the given
+          /// condition and parametrizer constraints.
+          /// \return the histogram registered by insertHistogram with the
+          ///         same constraints, or an empty pointer.
+          LeafHistogramPtr_t leafHistogram
+            (const NumericalConstraints_t& condition,
+             const NumericalConstraints_t& parametrizer) const;
+
+          /// Unregister an histogram if no LevelSetEdge uses it anymore.
+          void removeHistogram (const LeafHistogramPtr_t& hist);
+
           /// Get the histograms
           const Histograms_t& histograms () const
           {
@@ -288,6 +319,11 @@ namespace hpp {
 
           /// List of histograms
           Histograms_t hists_;
+          /// Histograms of foliations, indexed by condition and parametrizer
+          typedef std::map < std::pair < NumericalConstraints_t,
+                  NumericalConstraints_t >, LeafHistogramPtr_t >
+                    LeafHistograms_t;
+          LeafHistograms_t leafHists_;
 
           /// Map of constraint sets (from Edge).
           typedef std::map  < EdgePtr_t, ConstraintSetPtr_t > MapFromEdge;
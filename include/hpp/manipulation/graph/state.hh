@@ -22,6 +22,7 @@
 #include <hpp/core/constraint-set.hh>
 #include <hpp/core/config-projector.hh>
 #include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/matrix-view.hh>
 
 #include "hpp/manipulation/config.hh"
 #include "hpp/manipulation/fwd.hh"
@@ -69,6 +70,9 @@ namespace hpp {
           /// \note You should not use this method to know in which states a
           /// configuration is. This only checks if the configuration satisfies
           /// the constraints. Instead, use the class StateSelector.
+          /// \note the result is cached per thread for the last tested
+          ///       configuration, so that the constraints are not evaluated
+          ///       again when the same configuration is tested.
           virtual bool contains (ConfigurationIn_t config) const;
 
           inline bool isWaypoint () const
@@ -105,6 +109,27 @@ namespace hpp {
             return neighbors_.values();
           }
 
+          /// Choose an outgoing edge according to the weights.
+          ///
+          /// Sampling uses an alias table, built when the weights change,
+          /// so that it runs in constant time without allocation.
+          /// \return NULL if the total weight is 0.
+          EdgePtr_t chooseEdge () const;
+
+          /// Get the probabilities of the neighbors.
+          /// \return the probability of each edge of
+          ///         neighborEdgesProbabilities.
+          const vector_t& neighborProbabilities () const
+          {
+            return probabilities_;
+          }
+
+          /// Get the neighbors in the order of neighborProbabilities.
+          const Edges_t& neighborEdgesProbabilities () const
+          {
+            return aliasEdges_;
+          }
+
           /// Get the hidden neighbors
           /// It is a vector of transitions outgoing from this state and that are
           /// included in a waypoint edge.
@@ -126,6 +151,27 @@ namespace hpp {
             return configConstraints_;
           }
 
+          /// Configuration variables that are not output of an explicit
+          /// constraint of the state.
+          ///
+          /// Inside the state, the other configuration variables (locked
+          /// joints, pose of a grasped object...) are functions of these.
+          /// \sa freeVelocityVariables
+          const Eigen::RowBlockIndices& freeConfigurationVariables () const
+          {
+            throwIfNotInitialized ();
+            return freeConfigurationVariables_;
+          }
+
+          /// Velocity variables that are not output of an explicit
+          /// constraint of the state.
+          /// \sa freeConfigurationVariables
+          const Eigen::ColBlockIndices& freeVelocityVariables () const
+          {
+            throwIfNotInitialized ();
+            return freeVelocityVariables_;
+          }
+
           /// Add constraint to the state
 	  /// Call the parent implementation.
 	  /// \throw std::logic_error if the constraint is parameterizable
@@ -178,9 +224,25 @@ namespace hpp {
           Neighbors_t neighbors_;
           Edges_t hiddenNeighbors_;
 
+          /// Build the alias table of the neighbors.
+          void buildAliasTable ();
+
+          /// Alias table of the neighbors.
+          /// A slot i is drawn uniformly. Edge i is chosen with probability
+          /// aliasThreshold_[i] and edge alias_[i] otherwise.
+          Edges_t aliasEdges_;
+          vector_t probabilities_;
+          vector_t aliasThreshold_;
+          std::vector<std::size_t> alias_;
+
           /// Set of constraints to be statisfied.
           ConstraintSetPtr_t configConstraints_;
 
+          /// Variables not determined by the explicit constraints, computed
+          /// in initialize.
+          Eigen::RowBlockIndices freeConfigurationVariables_;
+          Eigen::ColBlockIndices freeVelocityVariables_;
+
           /// Stores the numerical constraints for path.
           NumericalConstraints_t numericalConstraintsForPath_;
 
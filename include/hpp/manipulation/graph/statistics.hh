@@ -141,18 +141,36 @@ namespace hpp {
           static LeafHistogramPtr_t create (const Foliation f);
 
           /// Insert an occurence of a value in the histogram
+          ///
+          /// The node is only queued. Evaluating the foliation is postponed
+          /// until the histogram is used, by flush, or until
+          /// \ref maxPendingNodes nodes are queued.
           void add (const RoadmapNodePtr_t& n);
 
+          /// Insert the queued nodes in the histogram.
+          /// This is called by getDistrib and
+          /// getDistribOutOfConnectedComponent.
+          void flush ();
+
+          /// Maximal number of queued nodes.
+          static const std::size_t maxPendingNodes = 1000;
+
+          /// Number of nodes waiting to be inserted.
+          std::size_t nbPendingNodes () const
+          {
+            return pending_.size();
+          }
+
           std::ostream& print (std::ostream& os) const;
 
           virtual HistogramPtr_t clone () const;
 
           statistics::DiscreteDistribution < RoadmapNodePtr_t > getDistribOutOfConnectedComponent (
-              const core::ConnectedComponentPtr_t& cc) const;
+              const core::ConnectedComponentPtr_t& cc);
 
-          statistics::DiscreteDistribution < RoadmapNodePtr_t > getDistrib () const;
+          statistics::DiscreteDistribution < RoadmapNodePtr_t > getDistrib ();
 
-          void clear () { Parent::clear(); }
+          void clear () { pending_.clear(); Parent::clear(); }
 
           const Foliation& foliation () const {
             return f_;
@@ -166,10 +184,16 @@ namespace hpp {
           LeafHistogram (const Foliation f);
 
         private:
+          /// Insert a node in its bin.
+          void insertNode (const RoadmapNodePtr_t& n);
+
           Foliation f_;
 
           /// Threshold used for equality between offset values.
           value_type threshold_;
+
+          /// Nodes added since the last flush.
+          std::vector<RoadmapNodePtr_t> pending_;
       };
 
       class HPP_MANIPULATION_DLLLOCAL StateHistogram : public ::hpp::statistics::Statistics < NodeBin >
@@ -0,0 +1,191 @@
+// Copyright (c) 2021 CNRS
+//
+// This file is part of hpp-manipulation
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_LAZY_PATH_HH
+# define HPP_MANIPULATION_LAZY_PATH_HH
+
+# include <list>
+# include <map>
+
+# include <hpp/core/path.hh>
+
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/config.hh>
+# include <hpp/manipulation/graph/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path
+    /// \{
+
+    /// Bounded set of the most recently built LazyPath.
+    ///
+    /// When more than \ref size lazy paths are built, the path of the
+    /// least recently used one is released.
+    class HPP_MANIPULATION_DLLAPI LazyPathCache
+    {
+    public:
+      static LazyPathCachePtr_t create (std::size_t size)
+      {
+        return LazyPathCachePtr_t (new LazyPathCache (size));
+      }
+
+      std::size_t size () const
+      {
+        return size_;
+      }
+
+      /// Number of lazy paths currently built.
+      std::size_t nbBuiltPaths () const
+      {
+        return paths_.size();
+      }
+
+    protected:
+      LazyPathCache (std::size_t size) : size_ (size) {}
+
+    private:
+      typedef std::list <const LazyPath*> LazyPaths_t;
+      typedef std::map <const LazyPath*, LazyPaths_t::iterator> Positions_t;
+
+      /// Mark p as most recently used and release the oldest paths.
+      void touch (const LazyPath* p) const;
+      /// Forget p.
+      void remove (const LazyPath* p) const;
+
+      std::size_t size_;
+      /// Most recently used first.
+      mutable LazyPaths_t paths_;
+      /// Position of each built path in paths_.
+      mutable Positions_t positions_;
+
+      friend class LazyPath;
+    }; // class LazyPathCache
+
+    /// A path built along an edge of the constraint graph when needed.
+    ///
+    /// Only the end configurations, the graph::Edge and the time range are
+    /// stored. The path is built by graph::Edge::build the first time it is
+    /// evaluated, and released when it leaves the LazyPathCache.
+    /// The built path is checked against the stored end configurations and
+    /// time range, and validated by the path validation of the edge, since
+    /// it may differ from the path validated when the lazy path was created.
+    /// The validation is done only the first time the path is built.
+    /// \warning the lazy path has no constraints. Use \ref path to get a
+    ///          path whose constraints can be inspected.
+    /// \warning this class and LazyPathCache are not thread-safe: evaluating
+    ///          lazy paths sharing a cache from several threads is undefined.
+    class HPP_MANIPULATION_DLLAPI LazyPath : public core::Path
+    {
+    public:
+      typedef core::Path Parent_t;
+      typedef core::PathPtr_t PathPtr_t;
+      typedef core::interval_t interval_t;
+
+      /// Return shared pointer to new object
+      /// \param edge the edge that builds the path,
+      /// \param q1, q2 the end configurations,
+      /// \param timeRange the time range of the path built by edge,
+      /// \param cache the set of built paths. If empty, the path is never
+      ///        released once built.
+      static LazyPathPtr_t create (const graph::EdgePtr_t& edge,
+          ConfigurationIn_t q1, ConfigurationIn_t q2,
+          const interval_t& timeRange, const LazyPathCachePtr_t& cache);
+
+      /// Return shared pointer to a copy
+      static LazyPathPtr_t createCopy (const LazyPath& path);
+
+      virtual ~LazyPath ();
+
+      virtual PathPtr_t copy () const
+      {
+        return createCopy (*this);
+      }
+
+      /// Build a copy of the path, with the given constraints.
+      virtual PathPtr_t copy (const core::ConstraintSetPtr_t& constraints) const
+      {
+        return path ()->copy (constraints);
+      }
+
+      /// Get the path, building it if necessary.
+      /// \throw std::runtime_error if the edge fails to build the path, or
+      ///        if the built path does not match the lazy path or is not
+      ///        valid.
+      /// \note the path is returned by value since it may be released by
+      ///       the LazyPathCache when another lazy path is built.
+      PathPtr_t path () const;
+
+      const graph::EdgePtr_t& edge () const
+      {
+        return edge_;
+      }
+
+      virtual Configuration_t initial () const
+      {
+        return q1_;
+      }
+
+      virtual Configuration_t end () const
+      {
+        return q2_;
+      }
+
+    protected:
+      /// Constructor
+      LazyPath (const graph::EdgePtr_t& edge,
+          ConfigurationIn_t q1, ConfigurationIn_t q2,
+          const interval_t& timeRange, const LazyPathCachePtr_t& cache);
+      /// Copy constructor
+      LazyPath (const LazyPath& other);
+      /// Store weak pointer to itself.
+      void init (const LazyPathPtr_t& self);
+
+      virtual bool impl_compute (ConfigurationOut_t result,
+                                 value_type param) const;
+
+      virtual void impl_derivative (vectorOut_t result, const value_type& param,
+                                    size_type order) const;
+
+      virtual void impl_velocityBound (vectorOut_t result,
+                                       const value_type& param0,
+                                       const value_type& param1) const;
+
+      virtual PathPtr_t impl_extract (const interval_t& paramInterval) const;
+
+      virtual std::ostream& print (std::ostream& os) const;
+
+    private:
+      graph::EdgePtr_t edge_;
+      Configuration_t q1_, q2_;
+      LazyPathCachePtr_t cache_;
+      mutable PathPtr_t path_;
+      /// Whether a built path was validated by the edge path validation.
+      mutable bool validated_;
+      LazyPathWkPtr_t weak_;
+
+      LazyPath() : validated_ (false) {}
+      HPP_SERIALIZABLE();
+
+      friend class LazyPathCache;
+    }; // class LazyPath
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+BOOST_CLASS_EXPORT_KEY(hpp::manipulation::LazyPath)
+
+#endif // HPP_MANIPULATION_LAZY_PATH_HH
@@ -17,6 +17,10 @@
 #ifndef HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 # define HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 
+#include <functional>
+#include <map>
+#include <set>
+
 #include <hpp/core/path-planner.hh>
 
 #include <hpp/statistics/success-bin.hh>
@@ -38,6 +42,10 @@ namespace hpp {
     {
       public:
         typedef std::list<std::size_t> ErrorFreqs_t;
+        /// Priority of the extension of a connected component from a state.
+        /// The higher, the sooner extended.
+        typedef std::function <value_type (const ConnectedComponentPtr_t&,
+            const graph::StatePtr_t&)> ExtensionPriority_t;
 
         /// Create an instance and return a shared pointer to the instance
         static ManipulationPlannerPtr_t create
@@ -49,6 +57,8 @@ namespace hpp {
         /// A set of constraints is chosen using the graph of constraints.
         /// A constraint extension is done using a chosen set.
         ///
+        /// \throw std::runtime_error if the roadmap already holds
+        ///        "ManipulationPlanner/maxNodes" nodes.
         virtual void oneStep ();
 
         /// Extend configuration q_near toward q_rand.
@@ -60,6 +70,26 @@ namespace hpp {
         bool extend (RoadmapNodePtr_t q_near,
             const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath);
 
+        /// Extend configuration q_near toward q_rand along a given edge.
+        /// \sa extend
+        bool extend (RoadmapNodePtr_t q_near, const graph::EdgePtr_t& edge,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath);
+
+        /// Extend configuration q_near backward, toward q_rand.
+        ///
+        /// A transition leading to the state of q_near is chosen. A
+        /// configuration is generated in the initial state of the transition,
+        /// in the same leaf as q_near, and a path of the transition to q_near
+        /// is built.
+        /// \param q_near the configuration to be extended.
+        /// \param q_rand the configuration toward extension is performed.
+        /// \retval validPath the longest valid path (possibly of length 0)
+        ///         ending at q_near, resulting from the extension.
+        /// \return True if the returned path is valid.
+        /// \sa parameter "ManipulationPlanner/bidirectional".
+        bool extendBackward (RoadmapNodePtr_t q_near,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath);
+
         /// Get the number of occurrence of each errors.
         ///
         /// \sa ManipulationPlanner::errorList
@@ -70,6 +100,52 @@ namespace hpp {
         /// \sa ManipulationPlanner::getEdgeStat
         static StringList_t errorList ();
 
+        /// Find a path in the roadmap.
+        ///
+        /// If parameter "ManipulationPlanner/lazyEdgePaths" is set, the
+        /// lazy paths of the solution are replaced by the paths they build.
+        virtual core::PathVectorPtr_t computePath () const;
+
+        /// Set the priority of the extensions.
+        ///
+        /// When parameter "ManipulationPlanner/maxExtensionsPerStep" is
+        /// positive, oneStep only extends the pairs (connected component,
+        /// state) of highest priority. By default, the priority is the
+        /// recent success rate of the extensions from the state, minus the
+        /// number of transitions to the goal state if parameter
+        /// "ManipulationPlanner/goalBias" is positive.
+        /// \sa extensionSuccessRate
+        void extensionPriority (const ExtensionPriority_t& priority)
+        {
+          extensionPriority_ = priority;
+        }
+
+        /// Restrict the planner to a set of states.
+        ///
+        /// Only the pairs (connected component, state) of these states are
+        /// extended, along the edges leading to these states.
+        /// \param states the allowed states. If empty, all the states are
+        ///        allowed.
+        /// \note when parameter "ManipulationPlanner/stateSequenceBudget" is
+        ///       positive, the allowed states are set at each step.
+        void allowedStates (const graph::States_t& states)
+        {
+          allowedStates_ = std::set <graph::StatePtr_t>
+            (states.begin (), states.end ());
+        }
+
+        /// Prepare the planner for a new resolution.
+        ///
+        /// If parameter "ManipulationPlanner/stateSequenceBudget" is
+        /// positive, the sequences of states are computed again.
+        virtual void startSolve ();
+
+        /// Recent success rate of the extensions from a state.
+        ///
+        /// It is an exponential moving average of the success of the
+        /// extensions, initialized to 0.5.
+        value_type extensionSuccessRate (const graph::StatePtr_t& state) const;
+
       protected:
         /// Protected constructor
         ManipulationPlanner (const ProblemConstPtr_t& problem,
@@ -85,6 +161,82 @@ namespace hpp {
         /// Try to connect nodes in a list between themselves.
         /// \return the number of connection made.
         std::size_t tryConnectNewNodes (const core::Nodes_t nodes);
+        /// Whether q, reached from near along path, should not be inserted
+        /// in the roadmap.
+        /// \sa parameter "ManipulationPlanner/redundancyThreshold".
+        bool isRedundant (const core::NodePtr_t& near,
+            const ConfigurationPtr_t& q, const core::PathPtr_t& path) const;
+        /// Same as extend.
+        /// \retval connectStep length of the path between the nodes to
+        ///         insert along validPath, 0 if a single node is inserted.
+        /// \sa parameter "ManipulationPlanner/connectLoopEdges".
+        bool extend (RoadmapNodePtr_t q_near,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath,
+            value_type& connectStep);
+        /// Same as extend along a given edge.
+        /// \retval connectStep see above.
+        bool extend (RoadmapNodePtr_t q_near, const graph::EdgePtr_t& edge,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath,
+            value_type& connectStep);
+
+        typedef std::pair <ConnectedComponentPtr_t, graph::StatePtr_t>
+          Extension_t;
+        typedef std::vector <Extension_t> Extensions_t;
+        /// Get the pairs (connected component, state) containing nodes.
+        /// At most "ManipulationPlanner/maxExtensionsPerStep" pairs of
+        /// highest priority are returned, if positive.
+        Extensions_t scheduleExtensions () const;
+
+        /// Compute goalDistances_ if the target of the problem is a state
+        /// and parameter "ManipulationPlanner/goalBias" is positive.
+        void updateGoalDistances ();
+        /// Number of transitions from a state to the goal state.
+        /// \return the number of states if the goal cannot be reached.
+        size_type goalDistance (const graph::StatePtr_t& state) const;
+        /// Choose an edge of positive weight leading closer to the goal.
+        /// \return NULL if there is none.
+        graph::EdgePtr_t chooseEdgeTowardGoal
+          (const graph::StatePtr_t& state) const;
+        /// Choose an edge of positive weight among the accepted ones,
+        /// according to the weights.
+        /// \return NULL if there is none.
+        graph::EdgePtr_t chooseEdge (const graph::Neighbors_t& neighbors,
+            const std::function <bool (const graph::EdgePtr_t&)>& accept)
+          const;
+        /// Whether a state is in allowedStates_.
+        bool isAllowed (const graph::StatePtr_t& state) const
+        {
+          return allowedStates_.empty () || allowedStates_.count (state) > 0;
+        }
+
+        /// Whether a connected component contains goal nodes but not the
+        /// initial node.
+        bool isGoalSide (const core::ConnectedComponentPtr_t& cc) const;
+        /// Try to connect the new nodes to the connected components of the
+        /// other side: from the initial node side to the goal side.
+        /// \return the number of connection made.
+        std::size_t tryConnectFrontiers (const core::Nodes_t& nodes);
+        /// Edges of positive weight leading to a state.
+        const graph::Neighbors_t& incomingEdges
+          (const graph::StatePtr_t& state);
+        /// Choose a transition leading to the target state of the problem
+        /// and shoot a random configuration projected in this state.
+        /// The random configuration is returned unprojected if the
+        /// projection fails.
+        /// \return NULL if the target is not a state or if no allowed
+        ///         transition leads to it.
+        ConfigurationPtr_t shootInTargetState (graph::EdgePtr_t& edge);
+        /// Constraints to generate the start of a path of edge, in the same
+        /// leaf as its end.
+        ConstraintSetPtr_t reverseTargetConstraint
+          (const graph::EdgePtr_t& edge);
+
+        /// Compute stateSequences_ from the states of the initial node to
+        /// the goal states.
+        void computeStateSequences ();
+        /// Set the allowed states to the current sequence, and move to the
+        /// next sequence when the budget is exhausted.
+        void updateStateSequence ();
 
         /// Configuration shooter
         ConfigurationShooterPtr_t shooter_;
@@ -118,8 +270,50 @@ namespace hpp {
         static const std::vector<Reason> reasons_;
 
         value_type extendStep_;
+        /// Node budget and redundancy threshold.
+        size_type maxNodes_;
+        value_type redundancyThreshold_;
+        /// Maximal number of extensions per step, 0 means no limit.
+        size_type maxExtensions_;
+        /// Probability of choosing an edge toward the goal state.
+        value_type goalBias_;
+        /// Goal state and number of transitions to it from each state.
+        graph::StatePtr_t goalState_;
+        graph::Graph::StateDistances_t goalDistances_;
+
+        /// See allowedStates.
+        std::set <graph::StatePtr_t> allowedStates_;
+        /// Number of steps of each sequence of states, 0 to disable them.
+        size_type sequenceBudget_;
+        /// Sequences of states from the initial state to the goal states,
+        /// the index of the current one and the number of steps done in it.
+        std::vector <graph::States_t> stateSequences_;
+        std::size_t currentSequence_;
+        size_type sequenceSteps_;
+        bool sequencesComputed_;
+
+        /// Whether goal connected components are extended backward.
+        bool bidirectional_;
+        /// Edges of positive weight leading to each state.
+        std::map <graph::StatePtr_t, graph::Neighbors_t> incomingEdges_;
+        /// See reverseTargetConstraint.
+        std::map <graph::EdgePtr_t, ConstraintSetPtr_t> reverseTargets_;
+
+        /// Whether loop transitions are extended as far as possible.
+        bool connectLoopEdges_;
+
+        /// Probability of generating a configuration in the target state
+        /// at each step.
+        value_type targetSamplingRate_;
+
+        /// Built paths of the lazy roadmap edges, if enabled.
+        LazyPathCachePtr_t lazyPathCache_;
 
         mutable Configuration_t qProj_;
+
+        ExtensionPriority_t extensionPriority_;
+        /// See extensionSuccessRate.
+        std::map <graph::StatePtr_t, value_type> extensionSuccessRate_;
     };
     /// \}
   } // namespace manipulation
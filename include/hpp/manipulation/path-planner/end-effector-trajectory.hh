@@ -24,7 +24,10 @@
 
 # include <pinocchio/spatial/se3.hpp>
 
+# include <hpp/statistics/success-bin.hh>
+
 # include <hpp/pinocchio/frame.hh>
+# include <hpp/pinocchio/liegroup-element.hh>
 # include <hpp/core/path-planner.hh>
 
 namespace hpp {
@@ -45,12 +48,75 @@ namespace hpp {
       };
       typedef shared_ptr<IkSolverInitialization> IkSolverInitializationPtr_t;
 
+      HPP_PREDEF_CLASS (SolutionMemory);
+      typedef shared_ptr<SolutionMemory> SolutionMemoryPtr_t;
+
+      /// Memory of the solutions found by EndEffectorTrajectory.
+      ///
+      /// Each entry associates the start of an end-effector trajectory
+      /// to the initial configuration of the robot that follows it.
+      /// A SolutionMemory outlives the path planners so that successive
+      /// queries on similar trajectories can be seeded from previous
+      /// solutions.
+      class HPP_MANIPULATION_DLLAPI SolutionMemory
+      {
+        public:
+          typedef std::vector<Configuration_t> Configurations_t;
+
+          /// \param capacity maximal number of entries. When full, the
+          ///        oldest entry is replaced.
+          static SolutionMemoryPtr_t create (size_type capacity = 1000)
+          {
+            return SolutionMemoryPtr_t (new SolutionMemory (capacity));
+          }
+
+          /// Store a solution.
+          /// \param start value of the end-effector trajectory at its start.
+          /// \param q initial configuration of the solution.
+          void add (LiegroupElementConstRef start, ConfigurationIn_t q);
+
+          /// Get the configurations of the k solutions whose start is the
+          /// closest to the given one, closest first.
+          /// Only entries of the same Lie group as start are considered.
+          Configurations_t nearest (LiegroupElementConstRef start,
+              size_type k) const;
+
+          size_type size () const
+          {
+            return (size_type)entries_.size();
+          }
+
+          void clear ()
+          {
+            entries_.clear();
+            next_ = 0;
+          }
+
+        protected:
+          SolutionMemory (size_type capacity)
+            : capacity_ (capacity), next_ (0)
+          {
+            assert (capacity > 0);
+          }
+
+        private:
+          typedef std::pair<LiegroupElement, Configuration_t> Entry_t;
+
+          size_type capacity_;
+          /// Index of the entry to replace when the memory is full.
+          std::size_t next_;
+          std::vector<Entry_t> entries_;
+      };
+
       HPP_PREDEF_CLASS (EndEffectorTrajectory);
       typedef shared_ptr<EndEffectorTrajectory> EndEffectorTrajectoryPtr_t;
 
       class HPP_MANIPULATION_DLLAPI EndEffectorTrajectory : public core::PathPlanner
       {
       public:
+        typedef ::hpp::statistics::SuccessStatistics SuccessStatistics;
+        typedef ::hpp::statistics::SuccessBin::Reason Reason;
+
         /// Return shared pointer to new instance
         /// \param problem the path planning problem
         static EndEffectorTrajectoryPtr_t create
@@ -100,11 +166,87 @@ namespace hpp {
           return feasibilityOnly_;
         }
 
+        /// If enabled, each configuration generated along the trajectory is
+        /// validated right after its projection. A seed is abandoned at the
+        /// first invalid step instead of after the last projection.
+        /// Disabled by default.
+        void validateIntermediateConfigs (bool enable)
+        {
+          validateConfigs_ = enable;
+        }
+
+        bool validateIntermediateConfigs () const
+        {
+          return validateConfigs_;
+        }
+
+        /// If enabled, the path between two consecutive steps is validated
+        /// as soon as both steps are computed, so that a seed is abandoned
+        /// at the first invalid interval. The whole path is still validated
+        /// once built. Disabled by default.
+        void validateIntermediatePaths (bool enable)
+        {
+          validatePaths_ = enable;
+        }
+
+        bool validateIntermediatePaths () const
+        {
+          return validatePaths_;
+        }
+
+        /// Get the statistics of the seeds tried since last call to
+        /// startSolve.
+        const SuccessStatistics& statistics () const
+        {
+          return statistics_;
+        }
+
+        /// Get the number of seeds abandoned at each step.
+        /// Index i corresponds to the projection or validation of the i-th
+        /// configuration along the trajectory (0 being the initial one).
+        const std::vector<size_type>& nbFailuresPerStep () const
+        {
+          return nbFailuresPerStep_;
+        }
+
+        /// Set an external IK solver.
+        /// The seeds are then the solutions it returns for the start of the
+        /// trajectory, instead of the initial and random configurations.
+        /// \sa solutionMemory
         void ikSolverInitialization (IkSolverInitializationPtr_t solver)
         {
           ikSolverInit_ = solver;
         }
 
+        /// Set the memory of previous solutions.
+        /// When set, the seeds of a query are, in this order, the initial
+        /// configuration, the solutions of the \ref nMemorySeeds previous
+        /// trajectories that start the closest to the current one and
+        /// \ref nRandomConfig random configurations. If an
+        /// IkSolverInitialization is set, the seeds are the previous
+        /// solutions followed by the solutions of the IK solver for the
+        /// start of the trajectory. Each solution found is added to the
+        /// memory.
+        void solutionMemory (const SolutionMemoryPtr_t& memory)
+        {
+          memory_ = memory;
+        }
+
+        const SolutionMemoryPtr_t& solutionMemory () const
+        {
+          return memory_;
+        }
+
+        /// Number of seeds taken from the solution memory.
+        int nMemorySeeds () const
+        { return nMemorySeeds_; }
+
+        void nMemorySeeds (int n)
+        {
+          assert (n >= 0);
+          nMemorySeeds_ = n;
+        }
+
         void tryConnectInitAndGoals ();
 
       protected:
@@ -120,7 +262,11 @@ namespace hpp {
         void init (const EndEffectorTrajectoryWkPtr_t& weak);
 
       private:
-        std::vector<core::Configuration_t> configurations(const core::Configuration_t& q_init);
+        std::vector<core::Configuration_t> configurations(const core::Configuration_t& q_init,
+            LiegroupElementConstRef start);
+
+        /// Register the failure of a seed at a given step.
+        void addFailure (int step, const Reason& reason);
 
         /// Weak pointer to itself
         EndEffectorTrajectoryWkPtr_t weak_;
@@ -132,6 +278,14 @@ namespace hpp {
         IkSolverInitializationPtr_t ikSolverInit_;
         /// Feasibility
         bool feasibilityOnly_;
+        /// Validation of each step
+        bool validateConfigs_, validatePaths_;
+        /// Previous solutions
+        SolutionMemoryPtr_t memory_;
+        int nMemorySeeds_;
+        /// Where the seeds die
+        SuccessStatistics statistics_;
+        std::vector<size_type> nbFailuresPerStep_;
       }; // class EndEffectorTrajectory
     } // namespace pathPlanner
   } // namespace manipulation
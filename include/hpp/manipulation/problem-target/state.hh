@@ -52,6 +52,11 @@ namespace hpp {
             state_ = state;
           }
 
+          const graph::StatePtr_t& target () const
+          {
+            return state_;
+          }
+
         protected:
           /// Constructor
           State (const core::ProblemPtr_t& problem)
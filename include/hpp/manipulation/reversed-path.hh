@@ -0,0 +1,133 @@
+// Copyright (c) 2021 CNRS
+//
+// This file is part of hpp-manipulation
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_REVERSED_PATH_HH
+# define HPP_MANIPULATION_REVERSED_PATH_HH
+
+# include <hpp/core/path.hh>
+
+# include <hpp/manipulation/fwd.hh>
+# include <hpp/manipulation/config.hh>
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path
+    /// \{
+
+    /// A path traversing another path backward.
+    ///
+    /// The original path is shared, not copied. This is used for the
+    /// reverse edges of the roadmap, that would otherwise each store a copy
+    /// of the forward path and of its constraints. The reversed path has
+    /// the constraints of the original path, and evaluates the original
+    /// path without them, so that they are applied once.
+    class HPP_MANIPULATION_DLLAPI ReversedPath : public core::Path
+    {
+    public:
+      typedef core::Path Parent_t;
+      typedef core::PathPtr_t PathPtr_t;
+      typedef core::interval_t interval_t;
+
+      /// Return shared pointer to new object
+      /// \param original the path to traverse backward.
+      /// \note use \ref reverse for a core::PathVector, whose sub-paths
+      ///       carry the constraints.
+      static ReversedPathPtr_t create (const PathPtr_t& original);
+
+      /// Traverse a path backward.
+      ///
+      /// A core::PathVector is reversed into a core::PathVector of the
+      /// reversed sub-paths, in reverse order, so that each sub-path keeps
+      /// the constraints of the transition it belongs to. The original of a
+      /// ReversedPath is returned. Other paths are wrapped in a
+      /// ReversedPath.
+      static PathPtr_t reverse (const PathPtr_t& path);
+
+      /// Return shared pointer to a copy
+      static ReversedPathPtr_t createCopy (const ReversedPath& path);
+
+      /// Return shared pointer to a copy with other constraints
+      static ReversedPathPtr_t createCopy (const ReversedPath& path,
+          const core::ConstraintSetPtr_t& constraints);
+
+      virtual PathPtr_t copy () const
+      {
+        return createCopy (*this);
+      }
+
+      virtual PathPtr_t copy (const core::ConstraintSetPtr_t& constraints) const;
+
+      /// Get the path traversed backward.
+      const PathPtr_t& original () const
+      {
+        return original_;
+      }
+
+      virtual Configuration_t initial () const
+      {
+        return original_->end ();
+      }
+
+      virtual Configuration_t end () const
+      {
+        return original_->initial ();
+      }
+
+    protected:
+      /// Constructor
+      ReversedPath (const PathPtr_t& original);
+      /// Copy constructor
+      ReversedPath (const ReversedPath& other);
+      /// Copy constructor with constraints
+      ReversedPath (const ReversedPath& other,
+          const core::ConstraintSetPtr_t& constraints);
+      /// Store weak pointer to itself.
+      void init (const ReversedPathPtr_t& self);
+
+      virtual bool impl_compute (ConfigurationOut_t result,
+                                 value_type param) const;
+
+      virtual void impl_derivative (vectorOut_t result, const value_type& param,
+                                    size_type order) const;
+
+      virtual void impl_velocityBound (vectorOut_t result,
+                                       const value_type& param0,
+                                       const value_type& param1) const;
+
+      virtual PathPtr_t impl_extract (const interval_t& paramInterval) const;
+
+      virtual std::ostream& print (std::ostream& os) const;
+
+    private:
+      /// Time of the original path corresponding to param.
+      value_type originalTime (const value_type& param) const
+      {
+        return original_->timeRange ().second - param;
+      }
+
+      PathPtr_t original_;
+      ReversedPathWkPtr_t weak_;
+
+      ReversedPath() {}
+      HPP_SERIALIZABLE();
+    }; // class ReversedPath
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+BOOST_CLASS_EXPORT_KEY(hpp::manipulation::ReversedPath)
+
+#endif // HPP_MANIPULATION_REVERSED_PATH_HH
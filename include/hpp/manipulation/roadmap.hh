@@ -79,6 +79,28 @@ namespace hpp {
 	/// Get graph state corresponding to given roadmap node
 	graph::StatePtr_t getState(RoadmapNodePtr_t node);
 
+        /// Restrict the metric of nearestNodeInState to the free variables
+        /// of the state.
+        ///
+        /// The variables output of the explicit constraints of the state
+        /// are then ignored by the nearest neighbor search.
+        /// \note this only applies when the distance is a
+        ///       manipulation::WeighedDistance.
+        /// \warning a variable that is output of an explicit constraint with
+        ///          a non constant right hand side, like a locked joint of
+        ///          the graph, differs between leaves of the state. The
+        ///          nearest node may then lie in another leaf.
+        /// \sa graph::State::freeVelocityVariables
+        void reducedStateMetric (bool enable)
+        {
+          reducedStateMetric_ = enable;
+        }
+
+        bool reducedStateMetric () const
+        {
+          return reducedStateMetric_;
+        }
+
         /// Get leaf connected components
         ///
         /// Leaf connected components are composed of nodes
@@ -115,8 +137,9 @@ namespace hpp {
         graph::GraphPtr_t graph_;
         RoadmapWkPtr_t weak_;
         LeafConnectedComps_t leafCCs_;
+        bool reducedStateMetric_;
 
-        Roadmap() {}
+        Roadmap() : reducedStateMetric_ (false) {}
         HPP_SERIALIZABLE();
     };
     /// \}
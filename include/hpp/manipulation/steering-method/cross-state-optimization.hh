@@ -102,6 +102,19 @@ namespace hpp {
 
           core::SteeringMethodPtr_t copy () const;
 
+          /// Enumerate the sequences of transitions between two states.
+          ///
+          /// The sequences are found by the breadth first search of the
+          /// constraint graph used by this steering method, so that the
+          /// shortest sequences come first. Waypoint edges are expanded.
+          /// The transitions of weight 0 are skipped, and a sequence is
+          /// skipped if it visits the same set of states as a previous one.
+          /// \param maxDepth maximal number of transitions of a sequence,
+          /// \param maxSequences maximal number of sequences.
+          std::vector <graph::Edges_t> transitionSequences
+            (const graph::StatePtr_t& from, const graph::StatePtr_t& to,
+             std::size_t maxDepth, std::size_t maxSequences) const;
+
         protected:
           CrossStateOptimization (const ProblemConstPtr_t& problem) :
             SteeringMethod (problem),
@@ -67,6 +67,17 @@ namespace hpp {
           ///                  understood as SE3.
           void trajectory (const PathPtr_t& eeTraj, bool se3Output);
 
+          /// Set the right hand side of the function from a path
+          /// \param se3Output set to True if the output of path must be
+          ///                  understood as SE3.
+          /// \param precompute if True and eeTraj is piecewise linear in SE3,
+          ///        as returned by makePiecewiseLinearTrajectory, the segments
+          ///        are stored in a table. Evaluating the right hand side then
+          ///        takes constant time with respect to the number of
+          ///        segments. Otherwise, the path is evaluated directly.
+          void trajectory (const PathPtr_t& eeTraj, bool se3Output,
+              bool precompute);
+
           /// Set the right hand side of the function from another function.
           /// \param eeTraj a function whose input space is of dimension 1.
           /// \param timeRange the input range of eeTraj.
@@ -91,7 +102,9 @@ namespace hpp {
 
           /// Computes an core::InterpolatedPath from the provided interpolation
           /// points.
-          /// \param times the time of each configuration
+          /// \param times the time of each configuration. They must lie in
+          ///        timeRange(). The path is defined on [times[0], times[N-1]],
+          ///        which makes possible to build a portion of the trajectory.
           /// \param configs each column correspond to a configuration
           PathPtr_t projectedPath (vectorIn_t times, matrixIn_t configs) const;
 
@@ -19,6 +19,7 @@
 # define HPP_MANIPULATION_DISTANCE_HH
 
 # include <hpp/core/weighed-distance.hh>
+# include <hpp/constraints/matrix-view.hh>
 
 # include <hpp/manipulation/fwd.hh>
 # include <hpp/manipulation/config.hh>
@@ -53,6 +54,30 @@ namespace hpp {
         return graph_;
       }
 
+      /// Compute the distances between a configuration and a set of
+      /// configurations.
+      ///
+      /// \param q a configuration,
+      /// \param configs configurations, one per column,
+      /// \retval result result[i] is the distance between q and configs.col(i).
+      ///
+      /// Each type of joint is processed for all the columns at once:
+      /// differences of vector space joints are computed blockwise and
+      /// the rotation angles of SO(2) and SO(3) joints from the dot
+      /// products of the configurations. Joints of unsupported types make
+      /// this method call the distance on each column.
+      void distances (ConfigurationIn_t q, matrixIn_t configs,
+          vectorOut_t result) const;
+
+      /// Compute the distances on a subset of the degrees of freedom.
+      ///
+      /// Same as the previous method but only the joints with at least one
+      /// velocity variable in \c dofs are accounted for. The extra
+      /// configuration space is always accounted for.
+      /// \sa graph::State::freeVelocityVariables
+      void distances (ConfigurationIn_t q, matrixIn_t configs,
+          const Eigen::ColBlockIndices& dofs, vectorOut_t result) const;
+
     protected:
       WeighedDistance (const DevicePtr_t& robot, const graph::GraphPtr_t graph);
 
@@ -67,10 +92,31 @@ namespace hpp {
       void init (WeighedDistanceWkPtr_t self);
 
     private:
+      /// Compute segments_.
+      void initSegments (const DevicePtr_t& robot);
+
+      /// Add the squared distances of the joints to sq.
+      /// \param dofs if not NULL, only the joints in dofs are accounted for.
+      void squaredDistances (ConfigurationIn_t q, matrixIn_t configs,
+          const Eigen::ColBlockIndices* dofs, vectorOut_t sq) const;
+
       graph::GraphPtr_t graph_;
       WeighedDistanceWkPtr_t weak_;
 
-      WeighedDistance() {}
+      /// Description of a joint for method distances.
+      struct Segment {
+        /// Rank in configuration, size in configuration, rank and size in
+        /// velocity and type.
+        size_type rank, size, rankV, sizeV;
+        int type;
+      };
+      std::vector<Segment> segments_;
+      /// Whether method distances processes the joints by type. Otherwise,
+      /// some joints are not supported and it calls the distance on each
+      /// column.
+      bool batch_;
+
+      WeighedDistance() : batch_ (false) {}
       HPP_SERIALIZABLE();
     }; // class Distance
     /// \}
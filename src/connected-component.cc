@@ -18,6 +18,8 @@
 
 #include <hpp/manipulation/connected-component.hh>
 
+#include <algorithm>
+
 #include "hpp/manipulation/roadmap.hh"
 #include "hpp/manipulation/roadmap-node.hh"
 
@@ -25,6 +27,16 @@ namespace hpp {
   namespace manipulation {
     RoadmapNodes_t ConnectedComponent::empty_ = RoadmapNodes_t();
 
+    namespace {
+      /// Set column i of m, doubling the number of columns if needed.
+      void setColumn (matrix_t& m, size_type i, ConfigurationIn_t q)
+      {
+        if (i >= m.cols ())
+          m.conservativeResize (q.size (), std::max (2 * m.cols (), i + 1));
+        m.col (i) = q;
+      }
+    }
+
     bool ConnectedComponent::check () const
     {
       std::set <core::NodePtr_t> s1;
@@ -69,12 +81,21 @@ namespace hpp {
 	// find other graph state in this-graphStateMap_ -> merge their roadmap nodes
 	GraphStates_t::iterator mapIt = this->graphStateMap_.find(otherIt->first);
 	if (mapIt != this->graphStateMap_.end())	{
+          matrix_t& configs (configurationMap_[otherIt->first]);
+          const matrix_t& otherConfigs
+            (other->configurationMap_[otherIt->first]);
+          size_type n ((size_type)mapIt->second.size());
+          for (size_type k = 0; k < (size_type)otherIt->second.size(); ++k)
+            setColumn (configs, n + k, otherConfigs.col (k));
 	  mapIt->second.insert(mapIt->second.end(), otherIt->second.begin(), otherIt->second.end());
 	} else {
 	  this->graphStateMap_.insert(*otherIt);
+          configurationMap_[otherIt->first].swap
+            (other->configurationMap_[otherIt->first]);
 	}
       }
       other->graphStateMap_.clear();
+      other->configurationMap_.clear();
       assert (check ());
     } 
 
@@ -85,10 +106,19 @@ namespace hpp {
       const RoadmapNodePtr_t& n = static_cast <const RoadmapNodePtr_t> (node);
       RoadmapPtr_t roadmap = roadmap_.lock();
       if (!roadmap) throw std::logic_error("The roadmap of this ConnectedComponent as been deleted.");
-      graphStateMap_[roadmap->getState(n)].push_back(n);
+      addToState (n, roadmap->getState(n));
       assert (check ());
     }
 
+    void ConnectedComponent::addToState (const RoadmapNodePtr_t& node,
+        const graph::StatePtr_t& state)
+    {
+      RoadmapNodes_t& nodes (graphStateMap_[state]);
+      setColumn (configurationMap_[state], (size_type)nodes.size(),
+          *node->configuration());
+      nodes.push_back(node);
+    }
+
     const RoadmapNodes_t& ConnectedComponent::getRoadmapNodes (
         const graph::StatePtr_t graphState) const
     {
@@ -98,6 +128,16 @@ namespace hpp {
       return empty_;
     }
 
+    matrixIn_t ConnectedComponent::getConfigurations (
+        const graph::StatePtr_t graphState) const
+    {
+      std::map <graph::StatePtr_t, matrix_t>::const_iterator it
+        (configurationMap_.find(graphState));
+      static const matrix_t empty;
+      if (it == configurationMap_.end()) return empty;
+      return it->second.leftCols (getRoadmapNodes (graphState).size());
+    }
+
   } // namespace manipulation
 } // namespace hpp
 
@@ -16,18 +16,23 @@
 
 #include "hpp/manipulation/graph/edge.hh"
 
+#include <functional>
+#include <future>
 #include <sstream>
 
 #include <hpp/util/pointer.hh>
 #include <hpp/util/exception-factory.hh>
 
 #include <hpp/pinocchio/configuration.hh>
+#include <hpp/core/configuration-shooter.hh>
 #include <hpp/core/obstacle-user.hh>
 #include <hpp/core/path-vector.hh>
 #include <hpp/core/path-validation.hh>
 
 #include <hpp/constraints/differentiable-function.hh>
+#include <hpp/constraints/explicit.hh>
 #include <hpp/constraints/locked-joint.hh>
+#include <hpp/constraints/solver/by-substitution.hh>
 
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/problem.hh"
@@ -41,7 +46,7 @@ namespace hpp {
       Edge::Edge (const std::string& name) :
 	GraphComponent (name), isShort_ (false),
         pathConstraints_ (),
-	targetConstraints_ (),
+	targetConstraints_ (), targetExplicit_ (false),
         steeringMethod_ (),
         securityMargins_ (),
         pathValidation_ ()
@@ -163,11 +168,32 @@ namespace hpp {
         securityMargins_.setZero();
       }
 
+      // Whether all the constraints of the set are solved by the explicit
+      // constraint set of its config projector.
+      static bool isSolvedByExplicitSubstitution
+      (const ConstraintSetPtr_t& set)
+      {
+        ConfigProjectorPtr_t proj = set->configProjector ();
+        if (!proj) return false;
+        const constraints::ExplicitConstraintSet& ecs
+          (proj->solver ().explicitConstraintSet ());
+        for (const auto& nc : proj->numericalConstraints ()) {
+          constraints::ExplicitPtr_t enc
+            (HPP_DYNAMIC_PTR_CAST (constraints::Explicit, nc));
+          if (!enc || !ecs.contains (enc)) return false;
+        }
+        return true;
+      }
+
       void Edge::initialize ()
       {
         if (!isInit_) {
           targetConstraints_ = buildTargetConstraint ();
           pathConstraints_ = buildPathConstraint ();
+          targetExplicit_ = isSolvedByExplicitSubstitution (targetConstraints_);
+          hppDout (info, "Target constraints of edge " << name ()
+              << (targetExplicit_ ? " are" : " are not")
+              << " solved by explicit substitution.");
         }
         isInit_ = true;
       }
@@ -400,6 +426,19 @@ namespace hpp {
         ConfigProjectorPtr_t proj = c->configProjector ();
         proj->rightHandSideFromConfig (qStart);
         if (isShort_) q = qStart;
+        if (targetExplicit_) {
+          // Compute the output variables from the input variables. The
+          // statistics are updated as ConfigProjector::apply would do.
+          ::hpp::statistics::SuccessStatistics& ss = proj->statistics ();
+          if (proj->solver ().explicitConstraintSet ().solve (q)
+              && c->isSatisfied (q)) {
+            ss.addSuccess ();
+            return true;
+          }
+          ss.addFailure ();
+          hppDout (warning, c->name () << " explicit substitution failed.");
+          return false;
+        }
         if (c->apply (q)) return true;
 	const ::hpp::statistics::SuccessStatistics& ss = proj->statistics ();
 	if (ss.nbFailure () > ss.nbSuccess ()) {
@@ -436,6 +475,7 @@ namespace hpp {
       void WaypointEdge::initialize ()
       {
         Edge::initialize();
+        clearWaypointCache ();
         // Set error threshold of internal edge to error threshold of
         // waypoint edge divided by number of edges.
         assert(targetConstraint()->configProjector());
@@ -460,47 +500,64 @@ namespace hpp {
       bool WaypointEdge::build (core::PathPtr_t& path, ConfigurationIn_t q1,
           ConfigurationIn_t q2) const
       {
-        core::PathPtr_t p;
         core::PathVectorPtr_t pv = core::PathVector::create
           (graph_.lock ()->robot ()->configSize (),
            graph_.lock ()->robot ()->numberDof ());
-        // Many times, this will be called rigth after WaypointEdge::generateTargetConfig so config_
-        // already satisfies the constraints.
+        // Many times, this will be called after WaypointEdge::generateTargetConfig
+        // so the waypoints are cached and already satisfy the constraints.
         size_type n = edges_.size();
-        assert (configs_.cols() == n + 1);
-        bool useCache = lastSucceeded_
-          && configs_.col(0).isApprox (q1)
-          && configs_.col(n).isApprox (q2);
-        configs_.col(0) = q1;
-        configs_.col(n) = q2;
-
-        for (size_type i = 0; i < n; ++i) {
-          if (i < (n-1) && !useCache) configs_.col (i+1) = q2;
-          if (i < (n-1) && !edges_[i]->generateTargetConfig (configs_.col(i), configs_.col (i+1))) {
+        matrix_t configs (q1.size(), n + 1);
+        bool useCache = retrieveWaypoints (q1, q2, configs);
+        configs.col(0) = q1;
+        configs.col(n) = q2;
+
+        for (size_type i = 0; i < n-1; ++i) {
+          if (!useCache) configs.col (i+1) = q2;
+          if (!edges_[i]->generateTargetConfig (configs.col(i), configs.col (i+1))) {
             hppDout (info, "Waypoint edge " << name() << ": generateTargetConfig failed at waypoint " << i << "."
                 << "\nUse cache: " << useCache
                 );
-            lastSucceeded_ = false;
             return false;
           }
-          assert (targetConstraint());
-          assert (targetConstraint()->configProjector ());
-          value_type eps
-            (targetConstraint()->configProjector ()->errorThreshold ());
-          if ((configs_.col(i) - configs_.col (i+1)).squaredNorm () > eps*eps) {
-            if (!edges_[i]->build (p, configs_.col(i), configs_.col (i+1))) {
-              hppDout (info, "Waypoint edge " << name()
-                       << ": build failed at waypoint " << i << "."
-                       << "\nUse cache: " << useCache);
-              lastSucceeded_ = false;
-              return false;
-            }
-            pv->appendPath (p);
-          }
         }
 
+        // Build the path along each internal edge. The waypoints are all
+        // known so that the internal edges are independent.
+        assert (targetConstraint());
+        assert (targetConstraint()->configProjector ());
+        value_type eps
+          (targetConstraint()->configProjector ()->errorThreshold ());
+        std::vector<core::PathPtr_t> paths (n);
+        auto buildPath = [&] (size_type i) -> bool {
+          if ((configs.col(i) - configs.col (i+1)).squaredNorm () <= eps*eps)
+            return true;
+          if (edges_[i]->build (paths[i], configs.col(i), configs.col (i+1)))
+            return true;
+          hppDout (info, "Waypoint edge " << name()
+                   << ": build failed at waypoint " << i << "."
+                   << "\nUse cache: " << useCache);
+          return false;
+        };
+
+        bool success = true;
+        if (parallelBuild_ && n > 1) {
+          std::vector<std::future<bool> > results;
+          for (size_type i = 0; i < n; ++i)
+            results.push_back (std::async (std::launch::async, buildPath, i));
+          // Wait for all tasks since they reference local variables.
+          for (size_type i = 0; i < n; ++i)
+            success = results[i].get () && success;
+        } else {
+          for (size_type i = 0; success && i < n; ++i)
+            success = buildPath (i);
+        }
+        if (!success) return false;
+
+        for (size_type i = 0; i < n; ++i)
+          if (paths[i]) pv->appendPath (paths[i]);
+
+        if (!useCache) storeWaypoints (configs);
         path = pv;
-        lastSucceeded_ = true;
         return true;
       }
 
@@ -513,18 +570,33 @@ namespace hpp {
       bool WaypointEdge::generateTargetConfig (ConfigurationIn_t qStart,
                                                ConfigurationOut_t q) const
       {
-        assert (configs_.cols() == size_type(edges_.size() + 1));
-        configs_.col(0) = qStart;
+        matrix_t configs (qStart.size(), edges_.size() + 1);
+        configs.col(0) = qStart;
+        core::ConfigurationShooterPtr_t shooter;
+        if (nbLocalRestarts_ > 0 && graph_.lock()->problem())
+          shooter = graph_.lock()->problem()->configurationShooter();
         for (std::size_t i = 0; i < edges_.size (); ++i) {
-          configs_.col (i+1) = q;
-          if (!edges_[i]->generateTargetConfig (configs_.col(i), configs_.col (i+1))) {
-            q = configs_.col(i+1);
-            lastSucceeded_ = false;
+          configs.col (i+1) = q;
+          bool success = edges_[i]->generateTargetConfig (configs.col(i),
+                                                          configs.col (i+1));
+          // Keep waypoints 0 to i and restart the projection of waypoint
+          // i+1 from random configurations.
+          for (size_type k = 0; !success && shooter && k < nbLocalRestarts_; ++k) {
+            Configuration_t qRand;
+            shooter->shoot (qRand);
+            configs.col (i+1) = qRand;
+            success = edges_[i]->generateTargetConfig (configs.col(i),
+                                                       configs.col (i+1));
+            hppDout (info, "Waypoint edge " << name() << ": restart " << k
+                << " at waypoint " << i << (success ? " succeeded." : " failed."));
+          }
+          if (!success) {
+            q = configs.col(i+1);
             return false;
           }
         }
-        q = configs_.col(edges_.size());
-        lastSucceeded_ = true;
+        q = configs.col(edges_.size());
+        storeWaypoints (configs);
         return true;
       }
 
@@ -533,11 +605,75 @@ namespace hpp {
         edges_.resize (number + 1);
         states_.resize (number + 1);
         states_.back() = stateTo();
-        const size_type nbDof = graph_.lock ()->robot ()->configSize ();
-        configs_ = matrix_t (nbDof, number + 2);
+        clearWaypointCache ();
         invalidate();
       }
 
+      void WaypointEdge::waypointCacheSize (std::size_t size)
+      {
+        std::lock_guard<std::mutex> lock (cacheMutex_);
+        cacheSize_ = size;
+        while (cache_.size() > cacheSize_) cache_.pop_back();
+      }
+
+      void WaypointEdge::clearWaypointCache () const
+      {
+        std::lock_guard<std::mutex> lock (cacheMutex_);
+        cache_.clear();
+        nbHits_ = nbMisses_ = 0;
+      }
+
+      namespace {
+        std::size_t fingerprint (ConfigurationIn_t q1, ConfigurationIn_t q2)
+        {
+          std::hash<value_type> hash;
+          std::size_t seed = 0;
+          for (size_type i = 0; i < q1.size(); ++i)
+            seed ^= hash(q1[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+          for (size_type i = 0; i < q2.size(); ++i)
+            seed ^= hash(q2[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+          return seed;
+        }
+      }
+
+      bool WaypointEdge::retrieveWaypoints (ConfigurationIn_t q1,
+          ConfigurationIn_t q2, matrix_t& configs) const
+      {
+        size_type n = configs.cols() - 1;
+        std::size_t key (fingerprint (q1, q2));
+        std::lock_guard<std::mutex> lock (cacheMutex_);
+        for (WaypointCache_t::iterator it = cache_.begin(); it != cache_.end(); ++it) {
+          if (it->key == key && it->configs.cols() == n + 1
+              && it->configs.col(0) == q1 && it->configs.col(n) == q2) {
+            configs = it->configs;
+            cache_.splice (cache_.begin(), cache_, it);
+            ++nbHits_;
+            return true;
+          }
+        }
+        ++nbMisses_;
+        return false;
+      }
+
+      void WaypointEdge::storeWaypoints (const matrix_t& configs) const
+      {
+        size_type n = configs.cols() - 1;
+        std::size_t key (fingerprint (configs.col(0), configs.col(n)));
+        std::lock_guard<std::mutex> lock (cacheMutex_);
+        if (cacheSize_ == 0) return;
+        for (WaypointCache_t::iterator it = cache_.begin(); it != cache_.end(); ++it) {
+          if (it->key == key) {
+            cache_.erase (it);
+            break;
+          }
+        }
+        CachedWaypoints entry;
+        entry.key = key;
+        entry.configs = configs;
+        cache_.push_front (entry);
+        if (cache_.size() > cacheSize_) cache_.pop_back();
+      }
+
       void WaypointEdge::setWaypoint (const std::size_t index,
 				      const EdgePtr_t wEdge,
 				      const StatePtr_t wTo)
@@ -716,11 +852,33 @@ namespace hpp {
 
       void LevelSetEdge::buildHistogram ()
       {
+        GraphPtr_t g = graph_.lock ();
+        LeafHistogramPtr_t old (hist_);
+
+        // Share the histogram of the edges with the same foliation.
+        hist_ = g->leafHistogram (condNumericalConstraints_,
+            paramNumericalConstraints_);
+        if (hist_) {
+          hppDout(info, "LevelSetEdge " << name() << " shares histogram "
+              << hist_->foliation().condition()->name());
+          if (old && old != hist_) g->removeHistogram (old);
+          return;
+        }
+
         Foliation f;
 
         /// Build the constraint set.
-        std::string n = "(" + name () + ")";
-        GraphPtr_t g = graph_.lock ();
+        // The foliation may be shared with other edges: it is named after
+        // its constraints and not attached to this edge.
+        std::ostringstream oss;
+        oss << "(";
+        for (const auto& nc : condNumericalConstraints_)
+          oss << nc->function ().name () << " ";
+        oss << "/";
+        for (const auto& nc : paramNumericalConstraints_)
+          oss << " " << nc->function ().name ();
+        oss << ")";
+        std::string n = oss.str ();
 
         // The parametrizer
         ConstraintSetPtr_t param = ConstraintSet::create (g->robot (), "Set " + n);
@@ -731,7 +889,6 @@ namespace hpp {
           proj->add (nc);
 
         param->addConstraint (proj);
-        param->edge (wkPtr_.lock ());
 
         f.parametrizer (param);
 
@@ -755,11 +912,11 @@ namespace hpp {
             << "\nCondition:\n" << *cond
             );
 
-        // TODO: If hist_ is not NULL, remove the previous Histogram.
-        // It should not be of any use and it slows down node insertion in the
-        // roadmap.
         hist_ = LeafHistogram::create (f);
-        g->insertHistogram (hist_);
+        g->insertHistogram (hist_, condNumericalConstraints_,
+            paramNumericalConstraints_);
+        // The previous histogram slows down node insertion in the roadmap.
+        if (old) g->removeHistogram (old);
       }
 
       void LevelSetEdge::initialize ()
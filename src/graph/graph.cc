@@ -16,6 +16,9 @@
 
 #include "hpp/manipulation/graph/graph.hh"
 
+#include <functional>
+#include <queue>
+
 #include <hpp/util/assertion.hh>
 
 #include <hpp/manipulation/constraint-set.hh>
@@ -53,12 +56,48 @@ namespace hpp {
       void Graph::initialize()
       {
         hists_.clear ();
+        leafHists_.clear ();
         assert(components_.size() >= 1 && components_[0].lock() == wkPtr_.lock());
         for (std::size_t i = 1; i < components_.size(); ++i)
           components_[i].lock()->initialize();
         isInit_ = true;
       }
 
+      void Graph::insertHistogram (const LeafHistogramPtr_t& hist,
+          const NumericalConstraints_t& condition,
+          const NumericalConstraints_t& parametrizer)
+      {
+        leafHists_[std::make_pair (condition, parametrizer)] = hist;
+        insertHistogram (HistogramPtr_t (hist));
+      }
+
+      LeafHistogramPtr_t Graph::leafHistogram
+      (const NumericalConstraints_t& condition,
+       const NumericalConstraints_t& parametrizer) const
+      {
+        LeafHistograms_t::const_iterator it
+          (leafHists_.find (std::make_pair (condition, parametrizer)));
+        if (it == leafHists_.end()) return LeafHistogramPtr_t();
+        return it->second;
+      }
+
+      void Graph::removeHistogram (const LeafHistogramPtr_t& hist)
+      {
+        for (std::size_t i = 1; i < components_.size(); ++i) {
+          LevelSetEdgePtr_t e (HPP_DYNAMIC_PTR_CAST (LevelSetEdge,
+                components_[i].lock()));
+          if (e && e->histogram() == hist) return;
+        }
+        for (LeafHistograms_t::iterator it = leafHists_.begin();
+            it != leafHists_.end(); ++it) {
+          if (it->second == hist) {
+            leafHists_.erase (it);
+            break;
+          }
+        }
+        hists_.remove (hist);
+      }
+
       void Graph::invalidate ()
       {
         for (std::size_t i = 1; i < components_.size(); ++i)
@@ -152,6 +191,41 @@ namespace hpp {
         return stateSelector_->chooseEdge (from);
       }
 
+      Graph::StateDistances_t Graph::distancesToState
+      (const StatePtr_t& target) const
+      {
+        // Predecessors of each state with the number of transitions.
+        typedef std::pair <size_type, StatePtr_t> Predecessor_t;
+        std::map <StatePtr_t, std::vector <Predecessor_t> > predecessors;
+        for (const StatePtr_t& state : stateSelector_->getStates ()) {
+          for (Neighbors_t::const_iterator it = state->neighbors ().begin ();
+              it != state->neighbors ().end (); ++it) {
+            if (it->first <= 0) continue;
+            WaypointEdgePtr_t we (HPP_DYNAMIC_PTR_CAST (WaypointEdge,
+                  it->second));
+            size_type n (we ? (size_type)we->nbWaypoints () + 1 : 1);
+            predecessors[it->second->stateTo ()].push_back
+              (Predecessor_t (n, state));
+          }
+        }
+
+        // Dijkstra algorithm from the target, on the reversed edges.
+        StateDistances_t distances;
+        std::priority_queue <Predecessor_t, std::vector <Predecessor_t>,
+          std::greater <Predecessor_t> > queue;
+        queue.push (Predecessor_t (0, target));
+        while (!queue.empty ()) {
+          Predecessor_t current (queue.top ());
+          queue.pop ();
+          if (distances.count (current.second)) continue;
+          distances[current.second] = current.first;
+          for (const Predecessor_t& p : predecessors[current.second])
+            if (!distances.count (p.second))
+              queue.push (Predecessor_t (current.first + p.first, p.second));
+        }
+        return distances;
+      }
+
       void Graph::clearConstraintsAndComplement()
       {
         constraintsAndComplements_.clear();
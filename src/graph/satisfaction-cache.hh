@@ -0,0 +1,144 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_GRAPH_SATISFACTION_CACHE_HH
+# define HPP_MANIPULATION_GRAPH_SATISFACTION_CACHE_HH
+
+# include <atomic>
+# include <vector>
+
+# include <hpp/core/config-projector.hh>
+# include <hpp/core/constraint-set.hh>
+
+# include <hpp/manipulation/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      /// Cache of the constraint sets satisfied by a configuration.
+      ///
+      /// There is one cache per thread. It stores whether the last
+      /// configuration tested in the thread satisfies constraint sets,
+      /// identified by an address. Testing several times whether a
+      /// configuration lies in a state (StateSelector::getState,
+      /// Edge::canConnect, LeafHistogram::add...) then evaluates the
+      /// constraints, and thus computes the forward kinematics, once.
+      ///
+      /// The error threshold and the right hand side of the projector of
+      /// the constraint set are part of the key, so that a stored value is
+      /// not used after any of them changed. Call invalidate when the
+      /// constraints themselves change.
+      class SatisfactionCache
+      {
+        public:
+          /// Get the cache of the calling thread for a configuration.
+          /// The cache is cleared if the configuration differs from the
+          /// previous one.
+          static SatisfactionCache& get (ConfigurationIn_t q)
+          {
+            thread_local SatisfactionCache cache;
+            std::size_t g (generation ().load ());
+            if (cache.generation_ != g || cache.q_.size () != q.size ()
+                || cache.q_ != q) {
+              cache.q_ = q;
+              cache.generation_ = g;
+              cache.entries_.clear ();
+            }
+            return cache;
+          }
+
+          /// Clear the caches of all the threads.
+          static void invalidate ()
+          {
+            ++generation ();
+          }
+
+          /// Get the stored value for key and the current error threshold
+          /// and right hand side of constraints.
+          /// \return false if no value is stored.
+          bool find (const void* key, const core::ConstraintSetPtr_t& constraints,
+              bool& satisfied) const
+          {
+            for (std::size_t i = 0; i < entries_.size (); ++i) {
+              const Entry& e (entries_[i]);
+              if (e.key != key) continue;
+              const core::ConfigProjectorPtr_t& proj
+                (constraints->configProjector ());
+              if (proj) {
+                if (e.threshold != proj->errorThreshold ()) return false;
+                vector_t rhs (proj->rightHandSide ());
+                if (e.rhs.size () != rhs.size () || e.rhs != rhs)
+                  return false;
+              }
+              satisfied = e.satisfied;
+              return true;
+            }
+            return false;
+          }
+
+          void insert (const void* key,
+              const core::ConstraintSetPtr_t& constraints, bool satisfied)
+          {
+            const core::ConfigProjectorPtr_t& proj
+              (constraints->configProjector ());
+            for (std::size_t i = 0; i < entries_.size (); ++i)
+              if (entries_[i].key == key) {
+                set (entries_[i], proj, satisfied);
+                return;
+              }
+            entries_.push_back (Entry ());
+            entries_.back ().key = key;
+            set (entries_.back (), proj, satisfied);
+          }
+
+        private:
+          struct Entry {
+            const void* key;
+            value_type threshold;
+            vector_t rhs;
+            bool satisfied;
+          };
+
+          SatisfactionCache () : generation_ (0) {}
+
+          static void set (Entry& e, const core::ConfigProjectorPtr_t& proj,
+              bool satisfied)
+          {
+            if (proj) {
+              e.threshold = proj->errorThreshold ();
+              e.rhs = proj->rightHandSide ();
+            } else {
+              e.threshold = 0;
+              e.rhs.resize (0);
+            }
+            e.satisfied = satisfied;
+          }
+
+          static std::atomic<std::size_t>& generation ()
+          {
+            static std::atomic<std::size_t> g (1);
+            return g;
+          }
+
+          Configuration_t q_;
+          std::size_t generation_;
+          std::vector<Entry> entries_;
+      }; // class SatisfactionCache
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_GRAPH_SATISFACTION_CACHE_HH
@@ -97,12 +97,7 @@ namespace hpp {
 
       EdgePtr_t StateSelector::chooseEdge(RoadmapNodePtr_t from) const
       {
-        StatePtr_t state = getState (from);
-        const Neighbors_t neighborPicker = state->neighbors();
-        if (neighborPicker.totalWeight () == 0) {
-          return EdgePtr_t ();
-        }
-        return neighborPicker ();
+        return getState (from)->chooseEdge ();
       }
 
       std::ostream& StateSelector::dotPrint (std::ostream& os, dot::DrawingAttributes) const
@@ -16,13 +16,18 @@
 
 #include "hpp/manipulation/graph/state.hh"
 
+#include <cstdlib>
+
 #include <hpp/constraints/differentiable-function.hh>
+#include <hpp/constraints/solver/by-substitution.hh>
 
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/graph/edge.hh"
 #include "hpp/manipulation/graph/graph.hh"
 #include "hpp/manipulation/constraint-set.hh"
 
+#include "satisfaction-cache.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace graph {
@@ -52,14 +57,79 @@ namespace hpp {
 			     const size_type& w, EdgeFactory create)
       {
         EdgePtr_t newEdge = create(name, graph_, wkPtr_, to);
-        if (w >= 0) neighbors_.insert (newEdge, (Weight_t)w);
-        else hiddenNeighbors_.push_back (newEdge);
+        if (w >= 0) {
+          neighbors_.insert (newEdge, (Weight_t)w);
+          buildAliasTable ();
+        } else hiddenNeighbors_.push_back (newEdge);
         return newEdge;
       }
 
+      void State::buildAliasTable ()
+      {
+        aliasEdges_.clear ();
+        std::vector<value_type> weights;
+        for (Neighbors_t::const_iterator it = neighbors_.begin();
+            it != neighbors_.end(); ++it) {
+          aliasEdges_.push_back (it->second);
+          weights.push_back ((value_type)it->first);
+        }
+        const std::size_t n (aliasEdges_.size ());
+        probabilities_.resize (n);
+        aliasThreshold_.resize (n);
+        alias_.resize (n);
+        const value_type total (neighbors_.totalWeight ());
+        if (total <= 0) {
+          probabilities_.setZero ();
+          aliasThreshold_.resize (0);
+          alias_.clear ();
+          return;
+        }
+
+        // Vose's alias method
+        std::vector<std::size_t> small, large;
+        for (std::size_t i = 0; i < n; ++i) {
+          probabilities_[i] = weights[i] / total;
+          aliasThreshold_[i] = probabilities_[i] * (value_type)n;
+          alias_[i] = i;
+          if (aliasThreshold_[i] < 1) small.push_back (i);
+          else large.push_back (i);
+        }
+        while (!small.empty () && !large.empty ()) {
+          std::size_t s = small.back (); small.pop_back ();
+          std::size_t l = large.back ();
+          alias_[s] = l;
+          aliasThreshold_[l] -= 1 - aliasThreshold_[s];
+          if (aliasThreshold_[l] < 1) {
+            large.pop_back ();
+            small.push_back (l);
+          }
+        }
+        // Remaining slots are full, up to rounding errors.
+        for (std::size_t i = 0; i < small.size (); ++i)
+          aliasThreshold_[small[i]] = 1;
+        for (std::size_t i = 0; i < large.size (); ++i)
+          aliasThreshold_[large[i]] = 1;
+      }
+
+      EdgePtr_t State::chooseEdge () const
+      {
+        if (alias_.empty ()) return EdgePtr_t ();
+        const value_type u ((value_type)aliasEdges_.size () * rand ()
+            / ((value_type)RAND_MAX + 1));
+        const std::size_t i ((std::size_t)u);
+        if (u - (value_type)i < aliasThreshold_[i]) return aliasEdges_[i];
+        return aliasEdges_[alias_[i]];
+      }
+
       bool State::contains (ConfigurationIn_t config) const
       {
-        return configConstraint()->isSatisfied (config);
+        SatisfactionCache& cache (SatisfactionCache::get (config));
+        bool satisfied;
+        const ConstraintSetPtr_t& constraints (configConstraint ());
+        if (cache.find (this, constraints, satisfied)) return satisfied;
+        satisfied = constraints->isSatisfied (config);
+        cache.insert (this, constraints, satisfied);
+        return satisfied;
       }
 
       std::ostream& State::dotPrint (std::ostream& os, dot::DrawingAttributes da) const
@@ -108,6 +178,7 @@ namespace hpp {
       void State::initialize()
       {
         isInit_ = true;
+        SatisfactionCache::invalidate ();
 
         std::string n = "(" + name () + ")";
         GraphPtr_t g = graph_.lock ();
@@ -117,6 +188,14 @@ namespace hpp {
         g->insertNumericalConstraints (proj);
         insertNumericalConstraints (proj);
         configConstraints_->addConstraint (proj);
+
+        const constraints::ExplicitConstraintSet& ecs
+          (proj->solver ().explicitConstraintSet ());
+        freeConfigurationVariables_ = ecs.notOutArgs ();
+        freeVelocityVariables_ = ecs.notOutDers ();
+        hppDout (info, "State " << name () << ": "
+            << freeVelocityVariables_.nbCols () << " free dofs out of "
+            << g->robot ()->numberDof ());
       }
 
       void State::updateWeight (const EdgePtr_t& e, const Weight_t& w)
@@ -126,6 +205,8 @@ namespace hpp {
           if (it->second == e) {
             /// Update the weights
             neighbors_.insert (e, w);
+            buildAliasTable ();
+            return;
           }
         }
         hppDout (error, "Edge not found");
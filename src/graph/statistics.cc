@@ -18,6 +18,8 @@
 
 #include "hpp/manipulation/constraint-set.hh"
 
+#include "satisfaction-cache.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace graph {
@@ -155,6 +157,8 @@ namespace hpp {
         return os << "NodeBin (" << state()->name () << ")";
       }
 
+      const std::size_t LeafHistogram::maxPendingNodes;
+
       LeafHistogramPtr_t LeafHistogram::create (const Foliation f)
       {
         return LeafHistogramPtr_t (new LeafHistogram (f));
@@ -172,6 +176,21 @@ namespace hpp {
       }
 
       void LeafHistogram::add (const RoadmapNodePtr_t& n)
+      {
+        pending_.push_back (n);
+        if (pending_.size() >= maxPendingNodes) flush ();
+      }
+
+      void LeafHistogram::flush ()
+      {
+        if (pending_.empty()) return;
+        std::vector<RoadmapNodePtr_t> nodes;
+        nodes.swap (pending_);
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+          insertNode (nodes[i]);
+      }
+
+      void LeafHistogram::insertNode (const RoadmapNodePtr_t& n)
       {
         if (!f_.contains (*n->configuration())) return;
 	iterator it = insert (LeafBin (f_.parameter (*n->configuration()),
@@ -184,7 +203,8 @@ namespace hpp {
 
       std::ostream& LeafHistogram::print (std::ostream& os) const
       {
-        os << "Leaf Histogram of foliation " << f_.condition()->name() << std::endl;
+        os << "Leaf Histogram of foliation " << f_.condition()->name()
+          << " (" << pending_.size() << " pending nodes)" << std::endl;
         return Parent::print (os);
       }
 
@@ -232,8 +252,9 @@ namespace hpp {
       }
 
       statistics::DiscreteDistribution < RoadmapNodePtr_t > LeafHistogram::getDistribOutOfConnectedComponent (
-          const core::ConnectedComponentPtr_t& cc) const
+          const core::ConnectedComponentPtr_t& cc)
       {
+        flush ();
         statistics::DiscreteDistribution < RoadmapNodePtr_t > distrib;
         for (const_iterator bin = begin(); bin != end (); ++bin) {
           unsigned int w = bin->numberOfObsOutOfConnectedComponent (cc);
@@ -244,8 +265,9 @@ namespace hpp {
         return distrib;
       }
 
-      statistics::DiscreteDistribution < RoadmapNodePtr_t > LeafHistogram::getDistrib () const
+      statistics::DiscreteDistribution < RoadmapNodePtr_t > LeafHistogram::getDistrib ()
       {
+        flush ();
         statistics::DiscreteDistribution < RoadmapNodePtr_t > distrib;
         for (const_iterator bin = begin(); bin != end (); ++bin) {
           std::size_t w = bin->freq ();
@@ -263,12 +285,18 @@ namespace hpp {
 
       bool Foliation::contains (ConfigurationIn_t q) const
       {
-        return condition_->isSatisfied (q);
+        SatisfactionCache& cache (SatisfactionCache::get (q));
+        bool satisfied;
+        if (cache.find (condition_.get (), condition_, satisfied))
+          return satisfied;
+        satisfied = condition_->isSatisfied (q);
+        cache.insert (condition_.get (), condition_, satisfied);
+        return satisfied;
       }
 
       vector_t Foliation::parameter (ConfigurationIn_t q) const
       {
-        if (!condition_->isSatisfied (q)) {
+        if (!contains (q)) {
           hppDout (error, "Configuration not in the foliation");
         }
         return parametrizer_->configProjector()->rightHandSideFromConfig (q);
@@ -282,6 +310,7 @@ namespace hpp {
       void Foliation::condition (const ConstraintSetPtr_t c)
       {
         condition_ = c;
+        SatisfactionCache::invalidate ();
       }
 
       ConstraintSetPtr_t Foliation::parametrizer () const
@@ -0,0 +1,196 @@
+// Copyright (c) 2021 CNRS
+//
+// This file is part of hpp-manipulation
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/lazy-path.hh"
+
+#include <algorithm>
+
+#include <hpp/util/exception-factory.hh>
+#include <hpp/util/indent.hh>
+#include <hpp/util/serialization.hh>
+
+#include <pinocchio/serialization/eigen.hpp>
+
+#include <hpp/pinocchio/configuration.hh>
+#include <hpp/pinocchio/device.hh>
+
+#include <hpp/core/constraint-set.hh>
+#include <hpp/core/path-validation.hh>
+#include <hpp/core/path-validation-report.hh>
+
+#include "hpp/manipulation/device.hh"
+#include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/serialization.hh"
+
+namespace hpp {
+  namespace manipulation {
+    void LazyPathCache::touch (const LazyPath* p) const
+    {
+      Positions_t::iterator pos (positions_.find (p));
+      if (pos == positions_.end()) {
+        paths_.push_front (p);
+        positions_.insert (std::make_pair (p, paths_.begin()));
+      } else
+        paths_.splice (paths_.begin(), paths_, pos->second);
+      // p, in front, is never released.
+      while (paths_.size() > std::max (size_, std::size_t (1))) {
+        paths_.back()->path_.reset();
+        positions_.erase (paths_.back());
+        paths_.pop_back();
+      }
+    }
+
+    void LazyPathCache::remove (const LazyPath* p) const
+    {
+      Positions_t::iterator pos (positions_.find (p));
+      if (pos == positions_.end()) return;
+      paths_.erase (pos->second);
+      positions_.erase (pos);
+    }
+
+    LazyPathPtr_t LazyPath::create (const graph::EdgePtr_t& edge,
+        ConfigurationIn_t q1, ConfigurationIn_t q2,
+        const interval_t& timeRange, const LazyPathCachePtr_t& cache)
+    {
+      LazyPath* ptr = new LazyPath (edge, q1, q2, timeRange, cache);
+      LazyPathPtr_t shPtr (ptr);
+      ptr->init (shPtr);
+      return shPtr;
+    }
+
+    LazyPathPtr_t LazyPath::createCopy (const LazyPath& path)
+    {
+      LazyPath* ptr = new LazyPath (path);
+      LazyPathPtr_t shPtr (ptr);
+      ptr->init (shPtr);
+      return shPtr;
+    }
+
+    LazyPath::LazyPath (const graph::EdgePtr_t& edge,
+        ConfigurationIn_t q1, ConfigurationIn_t q2,
+        const interval_t& timeRange, const LazyPathCachePtr_t& cache) :
+      Parent_t (timeRange, q1.size(),
+          edge->parentGraph()->robot()->numberDof()),
+      edge_ (edge), q1_ (q1), q2_ (q2), cache_ (cache), validated_ (false)
+    {}
+
+    LazyPath::LazyPath (const LazyPath& other) :
+      Parent_t (other), edge_ (other.edge_), q1_ (other.q1_), q2_ (other.q2_),
+      cache_ (other.cache_), validated_ (other.validated_)
+    {}
+
+    LazyPath::~LazyPath ()
+    {
+      if (path_ && cache_) cache_->remove (this);
+    }
+
+    void LazyPath::init (const LazyPathPtr_t& self)
+    {
+      Parent_t::init (self);
+      weak_ = self;
+    }
+
+    core::PathPtr_t LazyPath::path () const
+    {
+      if (!path_) {
+        if (!edge_->build (path_, q1_, q2_)) {
+          path_.reset();
+          HPP_THROW (std::runtime_error, "Edge " << edge_->name()
+              << " failed to build path between "
+              << pinocchio::displayConfig (q1_) << " and "
+              << pinocchio::displayConfig (q2_));
+        }
+        // The edge may build another path than the one validated when this
+        // lazy path was created.
+        if (path_->timeRange() != timeRange()
+            || !path_->initial().isApprox (q1_)
+            || !path_->end().isApprox (q2_)) {
+          path_.reset();
+          HPP_THROW (std::runtime_error, "Edge " << edge_->name()
+              << " built a path that does not match the lazy path between "
+              << pinocchio::displayConfig (q1_) << " and "
+              << pinocchio::displayConfig (q2_));
+        }
+        // A path matching the lazy path and validated once is not validated
+        // again when rebuilt after being released.
+        const core::PathValidationPtr_t& pv (edge_->pathValidation ());
+        core::PathPtr_t validPart;
+        core::PathValidationReportPtr_t report;
+        if (!validated_ && pv
+            && !pv->validate (path_, false, validPart, report)) {
+          path_.reset();
+          HPP_THROW (std::runtime_error, "Edge " << edge_->name()
+              << " built an invalid path between "
+              << pinocchio::displayConfig (q1_) << " and "
+              << pinocchio::displayConfig (q2_));
+        }
+        validated_ = true;
+      }
+      if (cache_) cache_->touch (this);
+      return path_;
+    }
+
+    bool LazyPath::impl_compute (ConfigurationOut_t result,
+                                 value_type param) const
+    {
+      return (*path ()) (result, param);
+    }
+
+    void LazyPath::impl_derivative (vectorOut_t result,
+        const value_type& param, size_type order) const
+    {
+      path ()->derivative (result, param, order);
+    }
+
+    void LazyPath::impl_velocityBound (vectorOut_t result,
+        const value_type& param0, const value_type& param1) const
+    {
+      path ()->velocityBound (result, param0, param1);
+    }
+
+    core::PathPtr_t LazyPath::impl_extract
+    (const interval_t& paramInterval) const
+    {
+      return path ()->extract (paramInterval);
+    }
+
+    std::ostream& LazyPath::print (std::ostream& os) const
+    {
+      os << "LazyPath built by " << edge_->name() << incindent << iendl;
+      Parent_t::print (os);
+      os << iendl << "initial: " << pinocchio::displayConfig (q1_)
+        << iendl << "end: " << pinocchio::displayConfig (q2_);
+      return os << decindent;
+    }
+
+    template<class Archive>
+    void LazyPath::serialize(Archive & ar, const unsigned int version)
+    {
+      using namespace boost::serialization;
+      (void) version;
+      ar & make_nvp("base", base_object<core::Path>(*this));
+      ar & BOOST_SERIALIZATION_NVP(edge_);
+      ar & BOOST_SERIALIZATION_NVP(q1_);
+      ar & BOOST_SERIALIZATION_NVP(q2_);
+      ar & BOOST_SERIALIZATION_NVP(weak_);
+    }
+
+    HPP_SERIALIZATION_IMPLEMENT(LazyPath);
+  } // namespace manipulation
+} // namespace hpp
+
+BOOST_CLASS_EXPORT_IMPLEMENT(hpp::manipulation::LazyPath)
@@ -216,11 +216,8 @@ namespace hpp {
     void WeighedLeafConnectedComp::setFirstNode (const RoadmapNodePtr_t& node)
     {
       LeafConnectedComp::setFirstNode(node);
-      std::vector<value_type> p = state_->neighbors().probabilities();
-      p_.resize(p.size());
-      edges_ = state_->neighbors().values();
-      for (std::size_t i = 0; i < p.size(); ++i)
-        p_[i] = p[i];
+      p_ = state_->neighborProbabilities();
+      edges_ = state_->neighborEdgesProbabilities();
     }
 
     std::size_t WeighedLeafConnectedComp::indexOf (const graph::EdgePtr_t e) const
@@ -18,6 +18,11 @@
 
 #include <tuple>
 #include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
 
 #include <hpp/util/pointer.hh>
 #include <hpp/util/timer.hh>
@@ -26,22 +31,31 @@
 #include <hpp/pinocchio/configuration.hh>
 
 #include <hpp/core/path-validation.hh>
+#include <hpp/core/path-vector.hh>
 #include <hpp/core/connected-component.hh>
+#include <hpp/core/distance.hh>
 #include <hpp/core/path-projector.hh>
 #include <hpp/core/projection-error.hh>
 #include <hpp/core/nearest-neighbor.hh>
 #include <hpp/core/roadmap.hh>
 #include <hpp/core/configuration-shooter.hh>
+#include <hpp/core/config-projector.hh>
 
 #include "hpp/manipulation/graph/statistics.hh"
+#include "hpp/manipulation/constraint-set.hh"
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/connected-component.hh"
 #include "hpp/manipulation/problem.hh"
 #include "hpp/manipulation/roadmap.hh"
 #include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/reversed-path.hh"
+#include "hpp/manipulation/lazy-path.hh"
 #include "hpp/manipulation/graph-path-validation.hh"
 #include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/state.hh"
 #include "hpp/manipulation/graph/state-selector.hh"
+#include "hpp/manipulation/problem-target/state.hh"
+#include "hpp/manipulation/steering-method/cross-state-optimization.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -72,14 +86,14 @@ namespace hpp {
           const graph::StatePtr_t& s1, const graph::StatePtr_t& s2,
           const graph::GraphPtr_t& graph,
           const PathProjectorPtr_t& pathProjector,
-          const PathValidationPtr_t& pathValidation)
+          const PathValidationPtr_t& pathValidation,
+          graph::EdgePtr_t& edge)
       {
         assert (graph && s1 && s2);
         graph::Edges_t possibleEdges = graph->getEdges (s1, s2);
 
         core::PathPtr_t path, tmpPath;
 
-        graph::EdgePtr_t edge;
         for (std::size_t i = 0; i < possibleEdges.size(); ++i) {
           edge = possibleEdges[i];
           if (edge->build (path, q1, q2)) break;
@@ -159,67 +173,149 @@ namespace hpp {
 
     void ManipulationPlanner::oneStep ()
     {
+      if (maxNodes_ > 0
+          && roadmap ()->nodes ().size () >= (std::size_t)maxNodes_) {
+        std::ostringstream oss;
+        oss << "Maximal number of nodes (" << maxNodes_ << ") reached.";
+        throw std::runtime_error (oss.str ());
+      }
       HPP_START_TIMECOUNTER(oneStep);
 
       DevicePtr_t robot = HPP_DYNAMIC_PTR_CAST(Device, problem()->robot ());
       HPP_ASSERT(robot);
-      const graph::States_t& graphStates = problem_->constraintGraph ()
-        ->stateSelector ()->getStates ();
-      graph::States_t::const_iterator itState;
       core::Nodes_t newNodes;
       core::PathPtr_t path;
 
-      typedef std::tuple <core::NodePtr_t, ConfigurationPtr_t, core::PathPtr_t>
-	DelayedEdge_t;
+      // The first boolean is true if the path goes from the new configuration
+      // to the node. The second one is true if the node is the one inserted
+      // for the previous delayed edge.
+      typedef std::tuple <core::NodePtr_t, ConfigurationPtr_t, core::PathPtr_t,
+              bool, bool> DelayedEdge_t;
       typedef std::vector <DelayedEdge_t> DelayedEdges_t;
       DelayedEdges_t delayedEdges;
 
+      updateGoalDistances ();
+      updateStateSequence ();
+
       // Pick a random node
       ConfigurationPtr_t q_rand = shooter_->shoot();
 
-      // Extend each connected component
-      for (core::ConnectedComponents_t::const_iterator itcc =
-          roadmap ()->connectedComponents ().begin ();
-          itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
+      // Extend each connected component from the states it occupies
+      const Extensions_t extensions (scheduleExtensions ());
+      for (const Extension_t& extension : extensions) {
         // Find the nearest neighbor.
         core::value_type distance;
-        for (itState = graphStates.begin (); itState != graphStates.end (); ++itState) {
-          HPP_START_TIMECOUNTER(nearestNeighbor);
-          RoadmapNodePtr_t near = roadmap_->nearestNodeInState (q_rand, HPP_STATIC_PTR_CAST(ConnectedComponent,*itcc), *itState, distance);
-          HPP_STOP_TIMECOUNTER(nearestNeighbor);
-          HPP_DISPLAY_LAST_TIMECOUNTER(nearestNeighbor);
-          if (!near) continue;
+        HPP_START_TIMECOUNTER(nearestNeighbor);
+        RoadmapNodePtr_t near = roadmap_->nearestNodeInState (q_rand,
+            extension.first, extension.second, distance);
+        HPP_STOP_TIMECOUNTER(nearestNeighbor);
+        HPP_DISPLAY_LAST_TIMECOUNTER(nearestNeighbor);
+        if (!near) continue;
 
+        const bool backward (bidirectional_ && isGoalSide (extension.first));
+        value_type connectStep = 0;
+        HPP_START_TIMECOUNTER(extend);
+        bool pathIsValid = backward ? extendBackward (near, q_rand, path)
+          : extend (near, q_rand, path, connectStep);
+        HPP_STOP_TIMECOUNTER(extend);
+        HPP_DISPLAY_LAST_TIMECOUNTER(extend);
+        // Insert new path to q_near in roadmap
+        bool extended = false;
+        if (pathIsValid) {
+          value_type t_new = backward ? path->timeRange ().first
+            : path->timeRange ().second;
+          if (path->timeRange ().second != path->timeRange ().first) {
+            bool success;
+            ConfigurationPtr_t q_new (new Configuration_t
+                                      (path->eval(t_new, success)));
+            assert(success);
+            assert(!path->constraints() ||
+                   path->constraints()->isSatisfied(*q_new));
+            assert(problem_->constraintGraph ()->getState(*q_new));
+            if (connectStep > 0) {
+              // Split the path of a loop transition in several nodes. The
+              // tolerance avoids a last piece of length close to 0.
+              const value_type t0 = path->timeRange ().first;
+              const size_type n ((size_type)std::ceil
+                  ((t_new - t0) / connectStep - 1e-8));
+              bool chained = false;
+              for (size_type i = 0; i < n; ++i) {
+                value_type t = t0 + (value_type)i * connectStep;
+                value_type t1 = (i + 1 == n ? t_new : t + connectStep);
+                core::PathPtr_t piece;
+                try {
+                  piece = path->extract (core::interval_t (t, t1));
+                } catch (const core::projection_error& e) {
+                  hppDout (error, e.what());
+                  break;
+                }
+                delayedEdges.push_back (DelayedEdge_t (near,
+                      ConfigurationPtr_t (new Configuration_t (piece->end ())),
+                      piece, false, chained));
+                chained = true;
+              }
+            } else
+              delayedEdges.push_back (DelayedEdge_t (near, q_new, path,
+                    backward, false));
+            extended = true;
+          }
+        }
+        // The success rates are only used to schedule the extensions.
+        if (maxExtensions_ > 0) {
+          value_type& rate (extensionSuccessRate_.insert
+              (std::make_pair (extension.second, .5)).first->second);
+          rate = .9 * rate + .1 * (extended ? 1 : 0);
+        }
+      }
+
+      // Try to reach a configuration of the target state from each
+      // connected component.
+      graph::EdgePtr_t targetEdge;
+      ConfigurationPtr_t q_target;
+      if (targetSamplingRate_ > 0 && rand () < targetSamplingRate_ * RAND_MAX)
+        q_target = shootInTargetState (targetEdge);
+      if (q_target) {
+        for (const core::ConnectedComponentPtr_t& cc :
+            roadmap ()->connectedComponents ()) {
+          core::value_type distance;
+          RoadmapNodePtr_t near = roadmap_->nearestNodeInState (q_target,
+              HPP_STATIC_PTR_CAST (ConnectedComponent, cc),
+              targetEdge->stateFrom (), distance);
+          if (!near) continue;
           HPP_START_TIMECOUNTER(extend);
-          bool pathIsValid = extend (near, q_rand, path);
+          bool pathIsValid = extend (near, targetEdge, q_target, path);
           HPP_STOP_TIMECOUNTER(extend);
-          HPP_DISPLAY_LAST_TIMECOUNTER(extend);
-          // Insert new path to q_near in roadmap
-          if (pathIsValid) {
-            value_type t_final = path->timeRange ().second;
-            if (t_final != path->timeRange ().first) {
-	      bool success;
-              ConfigurationPtr_t q_new (new Configuration_t
-					(path->eval(t_final, success)));
-	      assert(success);
-	      assert(!path->constraints() ||
-		     path->constraints()->isSatisfied(*q_new));
-	      assert(problem_->constraintGraph ()->getState(*q_new));
-              delayedEdges.push_back (DelayedEdge_t (near, q_new, path));
-            }
-          }
+          if (pathIsValid &&
+              path->timeRange ().second != path->timeRange ().first)
+            delayedEdges.push_back (DelayedEdge_t (near,
+                  ConfigurationPtr_t (new Configuration_t (path->end ())),
+                  path, false, false));
         }
       }
 
       HPP_START_TIMECOUNTER(delayedEdges);
       // Insert delayed edges
+      core::NodePtr_t previous = NULL;
       for (const auto& edge : delayedEdges) {
-	const core::NodePtr_t& near = std::get<0>(edge);
+	const core::NodePtr_t near = std::get<4>(edge) ? previous
+          : std::get<0>(edge);
 	const ConfigurationPtr_t& q_new = std::get<1>(edge);
 	const core::PathPtr_t& validPath = std::get<2>(edge);
+        previous = NULL;
+        // The next step fails.
+        if (maxNodes_ > 0
+            && roadmap ()->nodes ().size () >= (std::size_t)maxNodes_)
+          break;
+        if (!near || isRedundant (near, q_new, validPath)) continue;
         core::NodePtr_t newNode = roadmap ()->addNode (q_new);
-	roadmap ()->addEdge (near, newNode, validPath);
-	roadmap ()->addEdge (newNode, near, validPath->reverse());
+        previous = newNode;
+        if (std::get<3>(edge)) {
+          roadmap ()->addEdge (newNode, near, validPath);
+          roadmap ()->addEdge (near, newNode, ReversedPath::reverse (validPath));
+        } else {
+          roadmap ()->addEdge (near, newNode, validPath);
+          roadmap ()->addEdge (newNode, near, ReversedPath::reverse (validPath));
+        }
         newNodes.push_back (newNode);
       }
       HPP_STOP_TIMECOUNTER(delayedEdges);
@@ -229,7 +325,10 @@ namespace hpp {
       const std::size_t nbConn = tryConnectNewNodes (newNodes);
       HPP_STOP_TIMECOUNTER(tryConnectNewNodes);
       HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectNewNodes);
-      if (nbConn == 0) {
+      // Greedily connect both sides of the roadmap
+      std::size_t nbFrontierConn = 0;
+      if (bidirectional_) nbFrontierConn = tryConnectFrontiers (newNodes);
+      if (nbConn == 0 && nbFrontierConn == 0) {
         HPP_START_TIMECOUNTER(tryConnectToRoadmap);
         tryConnectToRoadmap (newNodes);
         HPP_STOP_TIMECOUNTER(tryConnectToRoadmap);
@@ -251,23 +350,475 @@ namespace hpp {
       HPP_DISPLAY_TIMECOUNTER(validatePath);
     }
 
+    value_type ManipulationPlanner::extensionSuccessRate
+    (const graph::StatePtr_t& state) const
+    {
+      std::map <graph::StatePtr_t, value_type>::const_iterator it
+        (extensionSuccessRate_.find (state));
+      if (it == extensionSuccessRate_.end ()) return .5;
+      return it->second;
+    }
+
+    ManipulationPlanner::Extensions_t ManipulationPlanner::scheduleExtensions
+    () const
+    {
+      Extensions_t extensions;
+      for (const core::ConnectedComponentPtr_t& cc :
+          roadmap ()->connectedComponents ()) {
+        ConnectedComponentPtr_t mcc
+          (HPP_STATIC_PTR_CAST (ConnectedComponent, cc));
+        const std::size_t first (extensions.size ());
+        for (const auto& state : mcc->graphStates ())
+          if (!state.second.empty () && isAllowed (state.first))
+            extensions.push_back (Extension_t (mcc, state.first));
+        // graphStates is sorted by address. Sort by id so that the order
+        // does not depend on memory allocation.
+        std::sort (extensions.begin () + first, extensions.end (),
+            [] (const Extension_t& a, const Extension_t& b)
+            { return a.second->id () < b.second->id (); });
+      }
+      if (maxExtensions_ <= 0 || extensions.size () <= (std::size_t)maxExtensions_)
+        return extensions;
+
+      // Shuffle so that ties are broken randomly.
+      for (std::size_t i = extensions.size () - 1; i > 0; --i)
+        std::swap (extensions[i], extensions[rand () % (i + 1)]);
+      std::vector <std::pair <value_type, std::size_t> > priorities
+        (extensions.size ());
+      for (std::size_t i = 0; i < extensions.size (); ++i) {
+        const Extension_t& e (extensions[i]);
+        if (extensionPriority_)
+          priorities[i].first = extensionPriority_ (e.first, e.second);
+        else {
+          priorities[i].first = extensionSuccessRate (e.second);
+          if (goalState_)
+            priorities[i].first -= (value_type)goalDistance (e.second);
+        }
+        priorities[i].second = i;
+      }
+      std::partial_sort (priorities.begin (),
+          priorities.begin () + maxExtensions_, priorities.end (),
+          [] (const std::pair <value_type, std::size_t>& a,
+              const std::pair <value_type, std::size_t>& b)
+          { return a.first > b.first; });
+      Extensions_t selected ((std::size_t)maxExtensions_);
+      for (std::size_t i = 0; i < selected.size (); ++i)
+        selected[i] = extensions[priorities[i].second];
+      return selected;
+    }
+
+    void ManipulationPlanner::updateGoalDistances ()
+    {
+      graph::StatePtr_t goal;
+      if (goalBias_ > 0) {
+        problemTarget::StatePtr_t target (HPP_DYNAMIC_PTR_CAST
+            (problemTarget::State, problem_->target ()));
+        if (target) goal = target->target ();
+      }
+      if (goal == goalState_) return;
+      goalState_ = goal;
+      goalDistances_.clear ();
+      if (goal)
+        goalDistances_ = problem_->constraintGraph ()->distancesToState (goal);
+    }
+
+    size_type ManipulationPlanner::goalDistance
+    (const graph::StatePtr_t& state) const
+    {
+      graph::Graph::StateDistances_t::const_iterator it
+        (goalDistances_.find (state));
+      if (it == goalDistances_.end ())
+        return (size_type)problem_->constraintGraph ()->stateSelector ()
+          ->getStates ().size ();
+      return it->second;
+    }
+
+    graph::EdgePtr_t ManipulationPlanner::chooseEdgeTowardGoal
+    (const graph::StatePtr_t& state) const
+    {
+      const size_type d (goalDistance (state));
+      return chooseEdge (state->neighbors (),
+          [this, d] (const graph::EdgePtr_t& e)
+          { return isAllowed (e->stateTo ())
+                && goalDistance (e->stateTo ()) < d; });
+    }
+
+    graph::EdgePtr_t ManipulationPlanner::chooseEdge
+    (const graph::Neighbors_t& neighbors,
+     const std::function <bool (const graph::EdgePtr_t&)>& accept) const
+    {
+      graph::Weight_t total = 0;
+      for (graph::Neighbors_t::const_iterator it = neighbors.begin ();
+          it != neighbors.end (); ++it)
+        if (it->first > 0 && accept (it->second))
+          total += it->first;
+      if (total == 0) return graph::EdgePtr_t ();
+      graph::Weight_t r ((graph::Weight_t)(rand () % total));
+      for (graph::Neighbors_t::const_iterator it = neighbors.begin ();
+          it != neighbors.end (); ++it) {
+        if (it->first <= 0 || !accept (it->second)) continue;
+        if (r < it->first) return it->second;
+        r -= it->first;
+      }
+      return graph::EdgePtr_t ();
+    }
+
+    void ManipulationPlanner::startSolve ()
+    {
+      core::PathPlanner::startSolve ();
+      sequencesComputed_ = false;
+      incomingEdges_.clear ();
+      reverseTargets_.clear ();
+    }
+
+    bool ManipulationPlanner::isGoalSide
+    (const core::ConnectedComponentPtr_t& cc) const
+    {
+      if (roadmap ()->initNode ()->connectedComponent () == cc) return false;
+      for (const core::NodePtr_t& n : roadmap ()->goalNodes ())
+        if (n->connectedComponent () == cc) return true;
+      return false;
+    }
+
+    const graph::Neighbors_t& ManipulationPlanner::incomingEdges
+    (const graph::StatePtr_t& state)
+    {
+      if (incomingEdges_.empty ()) {
+        for (const graph::StatePtr_t& s : problem_->constraintGraph ()
+            ->stateSelector ()->getStates ())
+          for (graph::Neighbors_t::const_iterator it =
+              s->neighbors ().begin ();
+              it != s->neighbors ().end (); ++it)
+            if (it->first > 0)
+              incomingEdges_[it->second->stateTo ()].insert (it->second,
+                  it->first);
+      }
+      return incomingEdges_[state];
+    }
+
+    ConfigurationPtr_t ManipulationPlanner::shootInTargetState
+    (graph::EdgePtr_t& edge)
+    {
+      problemTarget::StatePtr_t target (HPP_DYNAMIC_PTR_CAST
+          (problemTarget::State, problem_->target ()));
+      if (!target || !target->target ()) return ConfigurationPtr_t ();
+
+      const graph::StatePtr_t& state (target->target ());
+
+      // Select a transition leading to the target state.
+      edge = chooseEdge (incomingEdges (state),
+          [this] (const graph::EdgePtr_t& e)
+          { return isAllowed (e->stateFrom ()); });
+      if (!edge) return ConfigurationPtr_t ();
+
+      // The sample is projected in the target state, so that the nearest
+      // node search accounts for it. extend projects it again in the leaf of
+      // the extended node. The raw sample is kept if the projection fails.
+      ConfigurationPtr_t q (shooter_->shoot ());
+      Configuration_t qProj (*q);
+      if (state->configConstraint ()->apply (qProj)) *q = qProj;
+      else hppDout (info, "Failed to project a configuration in target state "
+          << state->name ());
+      return q;
+    }
+
+    ConstraintSetPtr_t ManipulationPlanner::reverseTargetConstraint
+    (const graph::EdgePtr_t& edge)
+    {
+      std::map <graph::EdgePtr_t, ConstraintSetPtr_t>::const_iterator it
+        (reverseTargets_.find (edge));
+      if (it != reverseTargets_.end ()) return it->second;
+
+      graph::GraphPtr_t graph (problem_->constraintGraph ());
+      std::string n ("(reverse " + edge->name () + ")");
+      ConstraintSetPtr_t set (ConstraintSet::create (graph->robot (),
+            "Set " + n));
+      ConfigProjectorPtr_t proj (ConfigProjector::create (graph->robot (),
+            "proj_" + n, graph->errorThreshold (), graph->maxIterations ()));
+      // Constraints of the initial state and of the leaf of the transition.
+      NumericalConstraints_t nc (edge->stateFrom ()->configConstraint ()
+          ->configProjector ()->numericalConstraints ());
+      for (const ImplicitPtr_t& c : edge->pathConstraint ()
+          ->configProjector ()->numericalConstraints ())
+        if (std::find (nc.begin (), nc.end (), c) == nc.end ())
+          nc.push_back (c);
+      for (const ImplicitPtr_t& c : nc)
+        proj->add (c);
+      set->addConstraint (proj);
+      reverseTargets_[edge] = set;
+      return set;
+    }
+
+    bool ManipulationPlanner::extendBackward (RoadmapNodePtr_t n_near,
+        const ConfigurationPtr_t& q_rand, core::PathPtr_t& validPath)
+    {
+      graph::GraphPtr_t graph = problem_->constraintGraph ();
+      PathProjectorPtr_t pathProjector = problem_->pathProjector ();
+      pinocchio::DevicePtr_t robot (problem_->robot ());
+      value_type eps (graph->errorThreshold ());
+      const ConfigurationPtr_t q_near = n_near->configuration ();
+
+      // Select a transition leading to the state of the node.
+      HPP_START_TIMECOUNTER (chooseEdge);
+      graph::EdgePtr_t edge (chooseEdge
+          (incomingEdges (getState (graph, n_near)),
+           [this] (const graph::EdgePtr_t& e)
+           { return isAllowed (e->stateFrom ()); }));
+      HPP_STOP_TIMECOUNTER (chooseEdge);
+      if (!edge) return false;
+
+      // Generate a configuration in the initial state, in the leaf of the
+      // node.
+      qProj_ = *q_rand;
+      HPP_START_TIMECOUNTER (generateTargetConfig);
+      SuccessStatistics& es = edgeStat (edge);
+      ConstraintSetPtr_t target (reverseTargetConstraint (edge));
+      target->configProjector ()->rightHandSideFromConfig (*q_near);
+      if (!target->apply (qProj_)) {
+        HPP_STOP_TIMECOUNTER (generateTargetConfig);
+        es.addFailure (reasons_[FAILURE]);
+        es.addFailure (reasons_[PROJECTION]);
+        return false;
+      }
+      HPP_STOP_TIMECOUNTER (generateTargetConfig);
+      if (pinocchio::isApprox (robot, qProj_, *q_near, eps)) {
+        es.addFailure (reasons_[FAILURE]);
+        es.addFailure (reasons_[PATH_PROJECTION_ZERO]);
+        return false;
+      }
+      core::PathPtr_t path;
+      HPP_START_TIMECOUNTER (buildPath);
+      if (!edge->build (path, qProj_, *q_near)) {
+        HPP_STOP_TIMECOUNTER (buildPath);
+        es.addFailure (reasons_[FAILURE]);
+        es.addFailure (reasons_[STEERING_METHOD]);
+        return false;
+      }
+      HPP_STOP_TIMECOUNTER (buildPath);
+      // The end of the path must be kept, so that it is only accepted if
+      // fully projected.
+      core::PathPtr_t projPath;
+      if (pathProjector) {
+        HPP_START_TIMECOUNTER (projectPath);
+        if (!pathProjector->apply (path, projPath)) {
+          HPP_STOP_TIMECOUNTER (projectPath);
+          es.addFailure (reasons_[FAILURE]);
+          es.addFailure (reasons_[PATH_PROJECTION_SHORTER]);
+          return false;
+        }
+        HPP_STOP_TIMECOUNTER (projectPath);
+      } else projPath = path;
+      PathValidationPtr_t pathValidation (problem_->pathValidation ());
+      PathValidationReportPtr_t report;
+      core::PathPtr_t fullValidPath;
+      HPP_START_TIMECOUNTER (validatePath);
+      bool fullyValid = false;
+      try {
+        fullyValid = pathValidation->validate
+          (projPath, true, fullValidPath, report);
+      } catch (const core::projection_error& e) {
+        hppDout (error, e.what ());
+        es.addFailure (reasons_[FAILURE]);
+        es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
+        return false;
+      }
+      HPP_STOP_TIMECOUNTER (validatePath);
+      validPath = fullValidPath;
+      if (fullValidPath->length () == 0) {
+        es.addFailure (reasons_[FAILURE]);
+        es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
+        return false;
+      }
+      es.addSuccess ();
+      if (fullyValid) es.addFailure (reasons_ [REACHED_DESTINATION_NODE]);
+      else es.addFailure (reasons_ [PATH_VALIDATION_SHORTER]);
+      return true;
+    }
+
+    std::size_t ManipulationPlanner::tryConnectFrontiers
+    (const core::Nodes_t& nodes)
+    {
+      PathProjectorPtr_t pathProjector (problem()->pathProjector ());
+      graph::GraphPtr_t graph = problem_->constraintGraph ();
+      const core::ConnectedComponentPtr_t& initCC
+        (roadmap ()->initNode ()->connectedComponent ());
+      graph::EdgePtr_t edge;
+      std::size_t nbConnection = 0;
+      const std::size_t K = 7;
+      value_type distance;
+      for (const core::NodePtr_t& n1 : nodes) {
+        // Nodes of the goal side are connected from the initial node side
+        // and conversely.
+        const bool goalSide (isGoalSide (n1->connectedComponent ()));
+        if (!goalSide && n1->connectedComponent () != initCC) continue;
+        const Configuration_t& q1 (*n1->configuration ());
+        graph::StatePtr_t s1 = getState (graph, n1);
+        bool connectSucceed = false;
+        for (const core::ConnectedComponentPtr_t& cc :
+            roadmap ()->connectedComponents ()) {
+          if (cc == n1->connectedComponent ()) continue;
+          if (goalSide ? cc != initCC : !isGoalSide (cc)) continue;
+          core::Nodes_t knearest = roadmap()->nearestNeighbor ()
+            ->KnearestSearch (q1, cc, K, distance);
+          for (const core::NodePtr_t& n2 : knearest) {
+            const Configuration_t& q2 (*n2->configuration ());
+            graph::StatePtr_t s2 = getState (graph, n2);
+            const core::NodePtr_t& from (goalSide ? n2 : n1);
+            const core::NodePtr_t& to   (goalSide ? n1 : n2);
+            core::PathPtr_t path (goalSide
+                ? connect (q2, q1, s2, s1, graph, pathProjector,
+                  problem_->pathValidation(), edge)
+                : connect (q1, q2, s1, s2, graph, pathProjector,
+                  problem_->pathValidation(), edge));
+            if (path) {
+              nbConnection++;
+              roadmap ()->addEdge (from, to, path);
+              roadmap ()->addEdge (to, from, ReversedPath::reverse (path));
+              connectSucceed = true;
+              break;
+            }
+          }
+          if (connectSucceed) break;
+        }
+      }
+      return nbConnection;
+    }
+
+    void ManipulationPlanner::computeStateSequences ()
+    {
+      stateSequences_.clear ();
+      graph::GraphPtr_t graph (problem_->constraintGraph ());
+      graph::StatePtr_t init (graph->getState
+          (*roadmap ()->initNode ()->configuration ()));
+
+      // Goal states
+      graph::States_t goals;
+      problemTarget::StatePtr_t target (HPP_DYNAMIC_PTR_CAST
+          (problemTarget::State, problem_->target ()));
+      if (target) goals.push_back (target->target ());
+      for (const core::NodePtr_t& n : roadmap ()->goalNodes ()) {
+        graph::StatePtr_t goal (graph->getState (*n->configuration ()));
+        if (std::find (goals.begin (), goals.end (), goal) == goals.end ())
+          goals.push_back (goal);
+      }
+
+      steeringMethod::CrossStateOptimizationPtr_t search
+        (steeringMethod::CrossStateOptimization::create (problem_));
+      const std::size_t maxDepth ((std::size_t)problem_->getParameter
+          ("ManipulationPlanner/stateSequenceMaxDepth").intValue ());
+      const std::size_t maxSequences ((std::size_t)problem_->getParameter
+          ("ManipulationPlanner/maxStateSequences").intValue ());
+      std::vector <graph::Edges_t> transitions;
+      for (const graph::StatePtr_t& goal : goals) {
+        std::vector <graph::Edges_t> t (search->transitionSequences
+            (init, goal, maxDepth, maxSequences));
+        transitions.insert (transitions.end (), t.begin (), t.end ());
+      }
+      // Shortest sequences first
+      std::stable_sort (transitions.begin (), transitions.end (),
+          [] (const graph::Edges_t& a, const graph::Edges_t& b)
+          { return a.size () < b.size (); });
+
+      // The planner only uses the set of states of a sequence.
+      // transitionSequences returns distinct sets of states for each goal,
+      // but sequences toward different goals may visit the same states.
+      std::set <std::set <graph::StatePtr_t> > explored;
+      for (const graph::Edges_t& edges : transitions) {
+        if (stateSequences_.size () >= maxSequences) break;
+        graph::States_t states (1, init);
+        for (const graph::EdgePtr_t& e : edges) {
+          states.push_back (e->state ());
+          states.push_back (e->stateTo ());
+        }
+        if (explored.insert (std::set <graph::StatePtr_t>
+              (states.begin (), states.end ())).second)
+          stateSequences_.push_back (states);
+      }
+      hppDout (info, stateSequences_.size () << " sequences of states from "
+          << init->name ());
+    }
+
+    void ManipulationPlanner::updateStateSequence ()
+    {
+      if (sequenceBudget_ <= 0) return;
+      if (!sequencesComputed_) {
+        computeStateSequences ();
+        sequencesComputed_ = true;
+        currentSequence_ = 0;
+        sequenceSteps_ = 0;
+      } else if (++sequenceSteps_ >= sequenceBudget_
+          && currentSequence_ < stateSequences_.size ()) {
+        hppDout (info, "Abandon sequence of states " << currentSequence_);
+        ++currentSequence_;
+        sequenceSteps_ = 0;
+      }
+      // When all the sequences have been tried, plan without restriction.
+      if (currentSequence_ < stateSequences_.size ())
+        allowedStates (stateSequences_[currentSequence_]);
+      else
+        allowedStates_.clear ();
+    }
+
     bool ManipulationPlanner::extend(
         RoadmapNodePtr_t n_near,
         const ConfigurationPtr_t& q_rand,
         core::PathPtr_t& validPath)
+    {
+      value_type connectStep;
+      return extend (n_near, q_rand, validPath, connectStep);
+    }
+
+    bool ManipulationPlanner::extend(
+        RoadmapNodePtr_t n_near,
+        const graph::EdgePtr_t& edge,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath)
+    {
+      value_type connectStep;
+      return extend (n_near, edge, q_rand, validPath, connectStep);
+    }
+
+    bool ManipulationPlanner::extend(
+        RoadmapNodePtr_t n_near,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath,
+        value_type& connectStep)
     {
       graph::GraphPtr_t graph = problem_->constraintGraph ();
-      PathProjectorPtr_t pathProjector = problem_->pathProjector ();
-      pinocchio::DevicePtr_t robot (problem_->robot ());
-      value_type eps (graph->errorThreshold ());
+      connectStep = 0;
       // Select next node in the constraint graph.
-      const ConfigurationPtr_t q_near = n_near->configuration ();
       HPP_START_TIMECOUNTER (chooseEdge);
-      graph::EdgePtr_t edge = graph->chooseEdge (n_near);
+      graph::EdgePtr_t edge;
+      if (goalState_ && rand () < goalBias_ * RAND_MAX)
+        edge = chooseEdgeTowardGoal (graph->getState (n_near));
+      if (!edge) {
+        if (allowedStates_.empty ())
+          edge = graph->chooseEdge (n_near);
+        else
+          edge = chooseEdge (graph->getState (n_near)->neighbors (),
+              [this] (const graph::EdgePtr_t& e)
+              { return isAllowed (e->stateTo ()); });
+      }
       HPP_STOP_TIMECOUNTER (chooseEdge);
       if (!edge) {
         return false;
       }
+      return extend (n_near, edge, q_rand, validPath, connectStep);
+    }
+
+    bool ManipulationPlanner::extend(
+        RoadmapNodePtr_t n_near,
+        const graph::EdgePtr_t& edge,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath,
+        value_type& connectStep)
+    {
+      graph::GraphPtr_t graph = problem_->constraintGraph ();
+      PathProjectorPtr_t pathProjector = problem_->pathProjector ();
+      pinocchio::DevicePtr_t robot (problem_->robot ());
+      value_type eps (graph->errorThreshold ());
+      connectStep = 0;
+      const ConfigurationPtr_t q_near = n_near->configuration ();
       qProj_ = *q_rand;
       HPP_START_TIMECOUNTER (generateTargetConfig);
       SuccessStatistics& es = edgeStat (edge);
@@ -329,7 +880,11 @@ namespace hpp {
         validPath = fullValidPath;
         return false;
       } else {
-        if (extendStep_ == 1 || fullyValid) {
+        if (connectLoopEdges_ && edge->stateFrom () == edge->stateTo ()) {
+          // Keep the whole valid part. It is split in nodes by oneStep.
+          validPath = fullValidPath;
+          if (extendStep_ < 1) connectStep = extendStep_ * projPath->length ();
+        } else if (extendStep_ == 1 || fullyValid) {
           validPath = fullValidPath;
         } else {
           const value_type& length = fullValidPath->length();
@@ -362,6 +917,30 @@ namespace hpp {
       return true;
     }
 
+    bool ManipulationPlanner::isRedundant (const core::NodePtr_t& near,
+        const ConfigurationPtr_t& q, const core::PathPtr_t& path) const
+    {
+      const value_type threshold (redundancyThreshold_ * extendStep_);
+      if (threshold <= 0) return false;
+      // Nodes reached through a transition between two states are kept.
+      ConstraintSetPtr_t c (HPP_DYNAMIC_PTR_CAST (ConstraintSet,
+            path->constraints ()));
+      if (!c || !c->edge ()
+          || c->edge ()->stateFrom () != c->edge ()->stateTo ())
+        return false;
+
+      value_type distance;
+      RoadmapNodePtr_t nearest (roadmap_->nearestNodeInState (q,
+            HPP_STATIC_PTR_CAST (ConnectedComponent,
+              near->connectedComponent ()),
+            getState (problem_->constraintGraph (), near), distance));
+      if (nearest && distance < threshold) {
+        hppDout (info, "New node is redundant, it is not inserted.");
+        return true;
+      }
+      return false;
+    }
+
     ManipulationPlanner::SuccessStatistics& ManipulationPlanner::edgeStat
       (const graph::EdgePtr_t& edge)
     {
@@ -380,6 +959,7 @@ namespace hpp {
     {
       PathProjectorPtr_t pathProjector (problem()->pathProjector ());
       core::PathPtr_t path;
+      graph::EdgePtr_t edge;
       graph::GraphPtr_t graph = problem_->constraintGraph ();
       graph::Edges_t possibleEdges;
 
@@ -410,17 +990,16 @@ namespace hpp {
             assert (q1 != q2);
 
             path = connect (q1, q2, s1, s2, graph, pathProjector,
-			    problem_->pathValidation());
+			    problem_->pathValidation(), edge);
 
             if (path) {
               nbConnection++;
+              if (lazyPathCache_ && !pathProjector)
+                path = LazyPath::create (edge, q1, q2, path->timeRange(),
+                    lazyPathCache_);
               if (!_1to2) roadmap ()->addEdge (*itn1, *itn2, path);
-              if (!_2to1) {
-                core::interval_t timeRange = path->timeRange ();
-                roadmap ()->addEdge (*itn2, *itn1, path->extract
-                    (core::interval_t (timeRange.second,
-                                       timeRange.first)));
-              }
+              if (!_2to1)
+                roadmap ()->addEdge (*itn2, *itn1, ReversedPath::reverse (path));
               connectSucceed = true;
               break;
             }
@@ -435,6 +1014,7 @@ namespace hpp {
     {
       PathProjectorPtr_t pathProjector (problem()->pathProjector ());
       core::PathPtr_t path;
+      graph::EdgePtr_t edge;
       graph::GraphPtr_t graph = problem_->constraintGraph ();
       std::size_t nbConnection = 0;
       for (core::Nodes_t::const_iterator itn1 = nodes.begin ();
@@ -454,16 +1034,15 @@ namespace hpp {
           assert (q1 != q2);
 
           path = connect (q1, q2, s1, s2, graph, pathProjector,
-			  problem_->pathValidation());
+			  problem_->pathValidation(), edge);
           if (path) {
             nbConnection++;
+            if (lazyPathCache_ && !pathProjector)
+              path = LazyPath::create (edge, q1, q2, path->timeRange(),
+                  lazyPathCache_);
             if (!_1to2) roadmap ()->addEdge (*itn1, *itn2, path);
-            if (!_2to1) {
-              core::interval_t timeRange = path->timeRange ();
-              roadmap ()->addEdge (*itn2, *itn1, path->extract
-                  (core::interval_t (timeRange.second,
-                                     timeRange.first)));
-            }
+            if (!_2to1)
+              roadmap ()->addEdge (*itn2, *itn1, ReversedPath::reverse (path));
           }
         }
       }
@@ -477,6 +1056,23 @@ namespace hpp {
       problem_ (problem), roadmap_ (roadmap),
       extendStep_ (problem->getParameter
 		   ("ManipulationPlanner/extendStep").floatValue()),
+      maxNodes_ (problem->getParameter
+		 ("ManipulationPlanner/maxNodes").intValue()),
+      redundancyThreshold_ (problem->getParameter
+		 ("ManipulationPlanner/redundancyThreshold").floatValue()),
+      maxExtensions_ (problem->getParameter
+		 ("ManipulationPlanner/maxExtensionsPerStep").intValue()),
+      goalBias_ (problem->getParameter
+		 ("ManipulationPlanner/goalBias").floatValue()),
+      sequenceBudget_ (problem->getParameter
+		 ("ManipulationPlanner/stateSequenceBudget").intValue()),
+      currentSequence_ (0), sequenceSteps_ (0), sequencesComputed_ (false),
+      bidirectional_ (problem->getParameter
+		 ("ManipulationPlanner/bidirectional").boolValue()),
+      connectLoopEdges_ (problem->getParameter
+		 ("ManipulationPlanner/connectLoopEdges").boolValue()),
+      targetSamplingRate_ (problem->getParameter
+		 ("ManipulationPlanner/targetStateSamplingRate").floatValue()),
       qProj_ (problem->robot ()->configSize ())
     {}
 
@@ -484,6 +1080,30 @@ namespace hpp {
     {
       core::PathPlanner::init (weak);
       weakPtr_ = weak;
+      if (problem_->getParameter ("ManipulationPlanner/lazyEdgePaths").boolValue())
+        lazyPathCache_ = LazyPathCache::create ((std::size_t)problem_->getParameter
+            ("ManipulationPlanner/lazyPathCacheSize").intValue());
+    }
+
+    core::PathVectorPtr_t ManipulationPlanner::computePath () const
+    {
+      core::PathVectorPtr_t lazy (core::PathPlanner::computePath ());
+      if (!lazyPathCache_ || !lazy) return lazy;
+
+      // Replace lazy paths by the paths they build, so that path optimizers
+      // can access the constraints of each path.
+      core::PathVectorPtr_t result (core::PathVector::create
+          (lazy->outputSize(), lazy->outputDerivativeSize()));
+      for (std::size_t i = 0; i < lazy->numberPaths(); ++i) {
+        core::PathPtr_t p (lazy->pathAtRank (i));
+        LazyPathPtr_t lp (HPP_DYNAMIC_PTR_CAST (LazyPath, p));
+        ReversedPathPtr_t rp (HPP_DYNAMIC_PTR_CAST (ReversedPath, p));
+        if (lp) p = lp->path();
+        else if (rp && (lp = HPP_DYNAMIC_PTR_CAST (LazyPath, rp->original())))
+          p = ReversedPath::reverse (lp->path());
+        result->appendPath (p);
+      }
+      return result;
     }
 
     using core::Parameter;
@@ -494,6 +1114,84 @@ namespace hpp {
           "ManipulationPlanner/extendStep",
           "Step of the RRT extension",
           Parameter((value_type)1)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::BOOL,
+          "ManipulationPlanner/lazyEdgePaths",
+          "Whether the paths of the roadmap edges created when connecting "
+          "nodes are built only when needed. Paths are not stored lazily if "
+          "the problem has a path projector.",
+          Parameter(false)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/lazyPathCacheSize",
+          "Maximal number of lazy roadmap edge paths kept built.",
+          Parameter((size_type)100)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/maxNodes",
+          "Maximal number of nodes of the roadmap. Once it is reached, the "
+          "planner stops with an error. 0 means no limit.",
+          Parameter((size_type)0)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::FLOAT,
+          "ManipulationPlanner/redundancyThreshold",
+          "A new node reached through a loop transition is redundant, and not "
+          "inserted, if it is closer than this threshold times "
+          "ManipulationPlanner/extendStep to a node of the same connected "
+          "component in the same state. The check does not depend on "
+          "ManipulationPlanner/maxNodes. Existing nodes are never removed. "
+          "0 disables the check.",
+          Parameter((value_type)0)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/maxExtensionsPerStep",
+          "Maximal number of pairs (connected component, state) extended at "
+          "each step. The pairs of highest priority are extended. "
+          "0 means no limit.",
+          Parameter((size_type)0)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::FLOAT,
+          "ManipulationPlanner/goalBias",
+          "When the target of the problem is a state of the constraint "
+          "graph, probability of choosing an edge that reduces the number "
+          "of transitions to this state. If positive, this number also "
+          "lowers the priority of the extensions "
+          "(see ManipulationPlanner/maxExtensionsPerStep).",
+          Parameter((value_type)0)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/stateSequenceBudget",
+          "If positive, sequences of states from the initial state to the "
+          "goal states are computed first, shortest first. The planner then "
+          "explores the states of each sequence during this number of steps, "
+          "before moving to the next one. When all the sequences have been "
+          "tried, all the states are explored.",
+          Parameter((size_type)0)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/stateSequenceMaxDepth",
+          "Maximal number of transitions of the sequences of states. "
+          "See ManipulationPlanner/stateSequenceBudget.",
+          Parameter((size_type)4)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::INT,
+          "ManipulationPlanner/maxStateSequences",
+          "Maximal number of sequences of states. "
+          "See ManipulationPlanner/stateSequenceBudget.",
+          Parameter((size_type)10)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::BOOL,
+          "ManipulationPlanner/bidirectional",
+          "Whether the connected components containing goal nodes are "
+          "extended backward, along the transitions leading to their "
+          "states, and new nodes greedily connected to the other side of "
+          "the roadmap.",
+          Parameter(false)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::BOOL,
+          "ManipulationPlanner/connectLoopEdges",
+          "Whether extensions along transitions from a state to itself go "
+          "as far as possible toward the random configuration, in the style "
+          "of RRT-Connect. The valid part of the path is then split into "
+          "nodes, ManipulationPlanner/extendStep being the fraction of the "
+          "path between consecutive nodes.",
+          Parameter(false)));
+    core::Problem::declareParameter(ParameterDescription(Parameter::FLOAT,
+          "ManipulationPlanner/targetStateSamplingRate",
+          "When the target of the problem is a state of the constraint "
+          "graph, probability, at each step, of extending each connected "
+          "component along a transition leading to this state, toward a "
+          "random configuration projected in this state.",
+          Parameter((value_type)0)));
     HPP_END_PARAMETER_DECLARATION(ManipulationPlanner)
   } // namespace manipulation
 } // namespace hpp
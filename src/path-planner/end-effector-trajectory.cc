@@ -17,6 +17,8 @@
 
 # include <hpp/manipulation/path-planner/end-effector-trajectory.hh>
 
+# include <algorithm>
+
 # include <pinocchio/multibody/data.hpp>
 
 # include <hpp/util/exception-factory.hh>
@@ -40,6 +42,55 @@ namespace hpp {
     namespace pathPlanner {
       typedef manipulation::steeringMethod::EndEffectorTrajectory      SM_t;
       typedef manipulation::steeringMethod::EndEffectorTrajectoryPtr_t SMPtr_t;
+      typedef ::hpp::statistics::SuccessBin SuccessBin;
+
+      namespace {
+        /// Reasons why a seed is abandoned.
+        enum TypeOfFailure {
+          PROJECTION = 0,
+          CONFIG_VALIDATION = 1,
+          STEERING_METHOD = 2,
+          PATH_VALIDATION = 3
+        };
+        const std::vector<SuccessBin::Reason> reasons = {
+          SuccessBin::createReason("Projection failed"),              // PROJECTION = 0,
+          SuccessBin::createReason("Configuration is in collision"),  // CONFIG_VALIDATION = 1,
+          SuccessBin::createReason("Steering method failed"),         // STEERING_METHOD = 2,
+          SuccessBin::createReason("Path is in collision"),           // PATH_VALIDATION = 3
+        };
+      }
+
+      void SolutionMemory::add (LiegroupElementConstRef start,
+          ConfigurationIn_t q)
+      {
+        if (entries_.size() < (std::size_t)capacity_) {
+          entries_.push_back (Entry_t (LiegroupElement (start), q));
+          return;
+        }
+        entries_[next_] = Entry_t (LiegroupElement (start), q);
+        next_ = (next_ + 1) % entries_.size();
+      }
+
+      SolutionMemory::Configurations_t SolutionMemory::nearest
+      (LiegroupElementConstRef start, size_type k) const
+      {
+        typedef std::pair<value_type, std::size_t> Candidate_t;
+        std::vector<Candidate_t> candidates;
+        candidates.reserve (entries_.size());
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+          const LiegroupElement& s (entries_[i].first);
+          if (*s.space() != *start.space()) continue;
+          candidates.push_back (Candidate_t ((s - start).norm(), i));
+        }
+        std::size_t n = std::min ((std::size_t)k, candidates.size());
+        std::partial_sort (candidates.begin(), candidates.begin() + n,
+            candidates.end());
+
+        Configurations_t configs (n);
+        for (std::size_t i = 0; i < n; ++i)
+          configs[i] = entries_[candidates[i].second].second;
+        return configs;
+      }
 
       EndEffectorTrajectoryPtr_t EndEffectorTrajectory::create
       (const core::ProblemConstPtr_t& problem)
@@ -81,6 +132,9 @@ namespace hpp {
         // Tag init and goal configurations in the roadmap
         roadmap()->resetGoalNodes ();
 
+        statistics_.clear ();
+        nbFailuresPerStep_.assign (nDiscreteSteps_ + 1, 0);
+
         SMPtr_t sm (HPP_DYNAMIC_PTR_CAST (SM_t, problem()->steeringMethod()));
         if (!sm)
           throw std::invalid_argument ("Steering method must be of type hpp::manipulation::steeringMethod::EndEffectorTrajectory");
@@ -141,7 +195,10 @@ namespace hpp {
 
         core::interval_t timeRange (sm->timeRange());
 
-        std::vector<core::Configuration_t> qs (configurations(*problem()->initConfig()));
+        vector_t t0 (vector_t::Constant (1, timeRange.first));
+        LiegroupElement start ((*sm->trajectory()) (t0));
+
+        std::vector<core::Configuration_t> qs (configurations(*problem()->initConfig(), start));
         if (qs.empty()) {
           hppDout (info, "Failed to generate initial configs.");
           return;
@@ -167,8 +224,14 @@ namespace hpp {
             resetRightHandSide = false;
           }
           Configuration_t& q (qs[i]);
-          if (!constraints->apply (q)) continue;
-          if (!cfgValidation->validate (q, cfgReport)) continue;
+          if (!constraints->apply (q)) {
+            addFailure (0, reasons[PROJECTION]);
+            continue;
+          }
+          if (!cfgValidation->validate (q, cfgReport)) {
+            addFailure (0, reasons[CONFIG_VALIDATION]);
+            continue;
+          }
           resetRightHandSide = true;
 
           steps.col(0) = q;
@@ -181,15 +244,41 @@ namespace hpp {
               hppDout (info, "Failed to generate destination config.\n" << setpyformat
                   << *constraints
                   << "\nq=" << one_line (q));
+              addFailure (j, reasons[PROJECTION]);
+              success = false;
+              break;
+            }
+            // The last configuration is always validated below.
+            if (validateConfigs_ && j < nDiscreteSteps_
+                && !cfgValidation->validate (steps.col(j), cfgReport)) {
+              hppDout (info, "Config at step " << j << " is in collision.");
+              addFailure (j, reasons[CONFIG_VALIDATION]);
               success = false;
               break;
             }
+            if (validatePaths_) {
+              core::PathPtr_t step = sm->projectedPath
+                (times.segment(j-1, 2), steps.middleCols(j-1, 2));
+              core::PathPtr_t validPart;
+              if (!step) {
+                addFailure (j, reasons[STEERING_METHOD]);
+                success = false;
+                break;
+              }
+              if (!pathValidation->validate (step, false, validPart, pathReport)) {
+                hppDout (info, "Path before step " << j << " is in collision.");
+                addFailure (j, reasons[PATH_VALIDATION]);
+                success = false;
+                break;
+              }
+            }
           }
           if (!success) continue;
           success = false;
 
           if (!cfgValidation->validate (steps.col(nDiscreteSteps_), cfgReport)) {
             hppDout (info, "Destination config is in collision.");
+            addFailure (nDiscreteSteps_, reasons[CONFIG_VALIDATION]);
             continue;
           }
 
@@ -199,49 +288,78 @@ namespace hpp {
                 << "times: " << one_line(times) << '\n'
                 << "configs:\n" << condensed(steps.transpose()) << '\n'
                 );
+            addFailure (nDiscreteSteps_, reasons[STEERING_METHOD]);
             continue;
           }
 
+          // The whole path is validated even if each interval was, since
+          // the path built by the steering method may differ from the
+          // intervals.
           core::PathPtr_t validPart;
           if (!pathValidation->validate (path, false, validPart, pathReport)) {
             hppDout (info, "Path is in collision.");
+            addFailure (nDiscreteSteps_, reasons[PATH_VALIDATION]);
             continue;
           }
 
+          statistics_.addSuccess ();
           roadmap()->initNode (make_shared<Configuration_t>(steps.col(0)));
           core::NodePtr_t init = roadmap()->   initNode ();
           core::NodePtr_t goal = roadmap()->addGoalNode (
               make_shared<Configuration_t>(steps.col(nDiscreteSteps_)));
           roadmap()->addEdge (init, goal, path);
+          if (memory_) memory_->add (start, steps.col(0));
           success = true;
           if (feasibilityOnly_) break;
         }
+        hppDout (info, statistics_);
+      }
+
+      void EndEffectorTrajectory::addFailure (int step, const Reason& reason)
+      {
+        statistics_.addFailure (reason);
+        if (nbFailuresPerStep_.size() <= (std::size_t)step)
+          nbFailuresPerStep_.resize (step + 1, 0);
+        ++nbFailuresPerStep_[step];
       }
 
-      std::vector<core::Configuration_t> EndEffectorTrajectory::configurations(const core::Configuration_t& q_init)
+      std::vector<core::Configuration_t> EndEffectorTrajectory::configurations
+      (const core::Configuration_t& q_init, LiegroupElementConstRef start)
       {
+        std::vector<core::Configuration_t> previous;
+        if (memory_ && nMemorySeeds_ > 0)
+          previous = memory_->nearest (start, nMemorySeeds_);
+        hppDout (info, previous.size() << " seeds from previous solutions.");
+
         if (!ikSolverInit_) {
-          std::vector<core::Configuration_t> configs(nRandomConfig_ + 1);
+          std::vector<core::Configuration_t> configs(nRandomConfig_ + 1
+              + previous.size());
           configs[0] = q_init;
-          for (int i = 1; i < nRandomConfig_ + 1; ++i)
+          std::copy (previous.begin(), previous.end(), configs.begin() + 1);
+          for (std::size_t i = previous.size() + 1; i < configs.size(); ++i)
             problem()->configurationShooter()->shoot(configs[i]);
           return configs;
         }
 
-        // TODO Compute the target and call ikSolverInit_
-        // See https://gepgitlab.laas.fr/airbus-xtct/hpp_airbus_xtct for an
-        // example using IKFast.
-        throw std::runtime_error ("Using an IkSolverInitialization is not implemented yet");
+        // The previous solutions are tried before the solutions of the IK
+        // solver for the start of the trajectory.
+        std::vector<core::Configuration_t> configs (ikSolverInit_->solve
+            (start.vector()));
+        hppDout (info, configs.size() << " seeds from the IK solver.");
+        configs.insert (configs.begin(), previous.begin(), previous.end());
+        return configs;
       }
 
       EndEffectorTrajectory::EndEffectorTrajectory
-      (const core::ProblemConstPtr_t& problem) : core::PathPlanner (problem)
+      (const core::ProblemConstPtr_t& problem) : core::PathPlanner (problem),
+        statistics_ ("EndEffectorTrajectory")
       {}
 
       EndEffectorTrajectory::EndEffectorTrajectory
       (const core::ProblemConstPtr_t& problem,
        const core::RoadmapPtr_t& roadmap)
-        : core::PathPlanner (problem, roadmap)
+        : core::PathPlanner (problem, roadmap),
+        statistics_ ("EndEffectorTrajectory")
       {}
 
       void EndEffectorTrajectory::checkFeasibilityOnly (bool enable)
@@ -256,6 +374,9 @@ namespace hpp {
         nRandomConfig_ = 10;
         nDiscreteSteps_ = 1;
         feasibilityOnly_ = true;
+        validateConfigs_ = false;
+        validatePaths_ = false;
+        nMemorySeeds_ = 5;
       }
     } // namespace pathPlanner
   } // namespace manipulation
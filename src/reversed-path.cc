@@ -0,0 +1,168 @@
+// Copyright (c) 2021 CNRS
+//
+// This file is part of hpp-manipulation
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/reversed-path.hh"
+
+#include <hpp/util/indent.hh>
+#include <hpp/util/pointer.hh>
+#include <hpp/util/serialization.hh>
+
+#include <hpp/core/constraint-set.hh>
+#include <hpp/core/path-vector.hh>
+
+#include "hpp/manipulation/serialization.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      /// Access to the evaluation of a path without its constraints.
+      struct UnconstrainedEval : core::Path
+      {
+        typedef bool (core::Path::*Compute_t)
+          (ConfigurationOut_t, value_type) const;
+        typedef value_type (core::Path::*ParamAtTime_t)
+          (const value_type&) const;
+
+        static bool compute (const core::Path& path,
+            ConfigurationOut_t result, const value_type& time)
+        {
+          const Compute_t f (&UnconstrainedEval::impl_compute);
+          const ParamAtTime_t s (&UnconstrainedEval::paramAtTime);
+          return (path.*f) (result, (path.*s) (time));
+        }
+      };
+    }
+
+    ReversedPathPtr_t ReversedPath::create (const PathPtr_t& original)
+    {
+      ReversedPath* ptr = new ReversedPath (original);
+      ReversedPathPtr_t shPtr (ptr);
+      ptr->init (shPtr);
+      return shPtr;
+    }
+
+    core::PathPtr_t ReversedPath::reverse (const PathPtr_t& path)
+    {
+      ReversedPathPtr_t rp (HPP_DYNAMIC_PTR_CAST (ReversedPath, path));
+      if (rp) return rp->original ();
+      core::PathVectorPtr_t pv (HPP_DYNAMIC_PTR_CAST (core::PathVector, path));
+      if (!pv) return create (path);
+      core::PathVectorPtr_t result (core::PathVector::create
+          (pv->outputSize (), pv->outputDerivativeSize ()));
+      for (std::size_t i = pv->numberPaths (); i > 0; --i)
+        result->appendPath (reverse (pv->pathAtRank (i - 1)));
+      return result;
+    }
+
+    ReversedPathPtr_t ReversedPath::createCopy (const ReversedPath& path)
+    {
+      ReversedPath* ptr = new ReversedPath (path);
+      ReversedPathPtr_t shPtr (ptr);
+      ptr->init (shPtr);
+      return shPtr;
+    }
+
+    ReversedPathPtr_t ReversedPath::createCopy (const ReversedPath& path,
+        const core::ConstraintSetPtr_t& constraints)
+    {
+      ReversedPath* ptr = new ReversedPath (path, constraints);
+      ReversedPathPtr_t shPtr (ptr);
+      ptr->init (shPtr);
+      return shPtr;
+    }
+
+    core::PathPtr_t ReversedPath::copy
+    (const core::ConstraintSetPtr_t& constraints) const
+    {
+      return createCopy (*this, constraints);
+    }
+
+    // The constraints of the original path are shared so that the reversed
+    // path belongs to the same edge of the constraint graph. impl_compute
+    // evaluates the original path without them, so that they are applied
+    // once.
+    ReversedPath::ReversedPath (const PathPtr_t& original) :
+      Parent_t (interval_t (0, original->length ()),
+          original->outputSize (), original->outputDerivativeSize (),
+          original->constraints ()),
+      original_ (original)
+    {}
+
+    ReversedPath::ReversedPath (const ReversedPath& other) :
+      Parent_t (other), original_ (other.original_)
+    {}
+
+    ReversedPath::ReversedPath (const ReversedPath& other,
+        const core::ConstraintSetPtr_t& constraints) :
+      Parent_t (other, constraints), original_ (other.original_)
+    {}
+
+    void ReversedPath::init (const ReversedPathPtr_t& self)
+    {
+      Parent_t::init (self);
+      weak_ = self;
+    }
+
+    bool ReversedPath::impl_compute (ConfigurationOut_t result,
+                                     value_type param) const
+    {
+      return UnconstrainedEval::compute (*original_, result,
+          originalTime (param));
+    }
+
+    void ReversedPath::impl_derivative (vectorOut_t result,
+        const value_type& param, size_type order) const
+    {
+      original_->derivative (result, originalTime (param), order);
+      if (order % 2 == 1) result = - result;
+    }
+
+    void ReversedPath::impl_velocityBound (vectorOut_t result,
+        const value_type& param0, const value_type& param1) const
+    {
+      original_->velocityBound (result, originalTime (param1),
+          originalTime (param0));
+    }
+
+    core::PathPtr_t ReversedPath::impl_extract
+    (const interval_t& paramInterval) const
+    {
+      return original_->extract (interval_t (originalTime (paramInterval.first),
+            originalTime (paramInterval.second)));
+    }
+
+    std::ostream& ReversedPath::print (std::ostream& os) const
+    {
+      os << "ReversedPath:" << incindent << iendl;
+      Parent_t::print (os);
+      return os << iendl << *original_ << decindent;
+    }
+
+    template<class Archive>
+    void ReversedPath::serialize(Archive & ar, const unsigned int version)
+    {
+      using namespace boost::serialization;
+      (void) version;
+      ar & make_nvp("base", base_object<core::Path>(*this));
+      ar & BOOST_SERIALIZATION_NVP(original_);
+      ar & BOOST_SERIALIZATION_NVP(weak_);
+    }
+
+    HPP_SERIALIZATION_IMPLEMENT(ReversedPath);
+  } // namespace manipulation
+} // namespace hpp
+
+BOOST_CLASS_EXPORT_IMPLEMENT(hpp::manipulation::ReversedPath)
@@ -23,14 +23,17 @@
 
 #include <hpp/manipulation/roadmap.hh>
 #include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/connected-component.hh>
 #include <hpp/manipulation/leaf-connected-comp.hh>
 #include <hpp/manipulation/graph/state.hh>
 #include <hpp/manipulation/graph/statistics.hh>
+#include <hpp/manipulation/weighed-distance.hh>
 
 namespace hpp {
   namespace manipulation {
     Roadmap::Roadmap (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot) :
-      core::Roadmap (distance, robot), weak_ () {}
+      core::Roadmap (distance, robot), weak_ (),
+      reducedStateMetric_ (false) {}
 
     RoadmapPtr_t Roadmap::create (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot)
     {
@@ -102,6 +105,24 @@ namespace hpp {
       // std::cout << "State: "  << state->name () << std::endl;
       // std::cout << "roadmapNodes.size () = " << roadmapNodes.size ()
       // 		<< std::endl;
+
+      // Compute all the distances at once if the distance supports it, even
+      // for a single node, so that minDistance always uses the same metric.
+      WeighedDistancePtr_t wd (HPP_DYNAMIC_PTR_CAST (WeighedDistance, distance()));
+      const size_type n ((size_type)roadmapNodes.size());
+      if (wd && n > 0) {
+        matrixIn_t qs (connectedComponent->getConfigurations (state));
+        vector_t d (n);
+        if (reducedStateMetric_)
+          wd->distances (*configuration, qs,
+              state->freeVelocityVariables (), d);
+        else
+          wd->distances (*configuration, qs, d);
+        size_type best;
+        minDistance = d.minCoeff (&best);
+        return roadmapNodes[best];
+      }
+
       for (RoadmapNodes_t::const_iterator itNode = roadmapNodes.begin ();
           itNode != roadmapNodes.end (); ++itNode) {
         value_type d = (*distance()) (*(*itNode)->configuration (),
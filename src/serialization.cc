@@ -60,7 +60,7 @@ inline void ConnectedComponent::serialize(Archive& ar, const unsigned int versio
     RoadmapPtr_t roadmap = roadmap_.lock();
     for (const core::NodePtr_t& node : nodes()) {
       const RoadmapNodePtr_t& n = static_cast <const RoadmapNodePtr_t> (node);
-      graphStateMap_[roadmap->getState(n)].push_back(n);
+      addToState (n, roadmap->getState(n));
     }
   }
   //ar & BOOST_SERIALIZATION_NVP(graphStateMap_);
@@ -103,10 +103,14 @@ namespace hpp {
         typedef std::queue<state_with_depth_ptr_t> Queue_t;
         typedef std::set<EdgePtr_t> VisitedEdge_t;
         std::size_t maxDepth;
+        /// Whether the transitions of weight 0, never sampled, are skipped.
+        bool sampledOnly;
         StateMap_t parent1; // TODO, parent2;
         Queue_t queue1;
         VisitedEdge_t visitedEdge_;
 
+        GraphSearchData () : sampledOnly (false) {}
+
         const state_with_depth& getParent(const state_with_depth_ptr_t& _p) const
         {
           const state_with_depths_t& parents = _p.state->second;
@@ -212,6 +216,7 @@ namespace hpp {
 
             // Avoid identical consecutive transition
             if (transition == parent.e) continue;
+            if (d.sampledOnly && _n->first == 0) continue;
 
             // If transition has already been visited, continue
             // if (d.visitedEdge_.count (transition) == 1) continue;
@@ -614,6 +619,49 @@ namespace hpp {
         return pv;
       }
 
+      std::vector <Edges_t> CrossStateOptimization::transitionSequences
+      (const StatePtr_t& from, const StatePtr_t& to, std::size_t maxDepth,
+       std::size_t maxSequences) const
+      {
+        std::vector <Edges_t> sequences;
+        if (maxSequences == 0) return sequences;
+        GraphSearchData d;
+        d.s1 = from;
+        d.s2 = to;
+        d.maxDepth = maxDepth;
+        d.sampledOnly = true;
+
+        // Sets of states of the sequences found so far.
+        std::set <std::set <StatePtr_t> > visited;
+        d.queue1.push (d.addInitState());
+        std::size_t idxSol = (d.s1 == d.s2 ? 1 : 0);
+        bool maxDepthReached = findTransitions (d);
+
+        while (!maxDepthReached) {
+          if (d.parent1.find (d.s2) != d.parent1.end ()) {
+            Edges_t transitions = getTransitionList (d, idxSol);
+            while (! transitions.empty()) {
+              std::set <StatePtr_t> states;
+              states.insert (from);
+              for (const EdgePtr_t& e : transitions) {
+                states.insert (e->state ());
+                states.insert (e->stateTo ());
+              }
+              if (visited.insert (states).second) {
+                sequences.push_back (transitions);
+                if (sequences.size () >= maxSequences) return sequences;
+              }
+              ++idxSol;
+              transitions = getTransitionList(d, idxSol);
+            }
+          }
+          // The whole graph has been explored.
+          if (d.queue1.empty ()) break;
+          maxDepthReached = findTransitions (d);
+        }
+        return sequences;
+      }
+
       core::PathPtr_t CrossStateOptimization::impl_compute (
           ConfigurationIn_t q1, ConfigurationIn_t q2) const
       {
@@ -80,6 +80,125 @@ namespace hpp {
           private:
             PathPtr_t path_;
         };
+
+        /// Piecewise straight trajectory in SE(3) stored as a table of
+        /// segments.
+        ///
+        /// The segment containing a parameter is found in constant time by
+        /// means of a uniform grid over the time range. Each segment is then
+        /// interpolated in closed form from its initial pose and its
+        /// constant velocity.
+        class FunctionFromSE3Segments : public constraints::DifferentiableFunction
+        {
+          public:
+            /// Return an empty pointer if the path is not a core::PathVector
+            /// of unconstrained core::StraightPath in SE(3).
+            static DifferentiableFunctionPtr_t create (const PathPtr_t& p)
+            {
+              core::PathVectorPtr_t pv (HPP_DYNAMIC_PTR_CAST (core::PathVector, p));
+              if (!pv || pv->numberPaths() == 0
+                  || p->outputSize() != 7 || p->outputDerivativeSize() != 6)
+                return DifferentiableFunctionPtr_t();
+              shared_ptr<FunctionFromSE3Segments> f
+                (new FunctionFromSE3Segments (pv->numberPaths()));
+              if (!f->initialize (pv)) return DifferentiableFunctionPtr_t();
+              return f;
+            }
+
+            std::ostream& print (std::ostream& os) const
+            {
+              return os << "FunctionFromSE3Segments: "
+                << times_[0] << ", " << times_[times_.size()-1]
+                << " (" << q0_.cols() << " segments)";
+            }
+
+          protected:
+            void impl_compute (core::LiegroupElementRef result, vectorIn_t arg) const
+            {
+              size_type i = segment (arg[0]);
+              value_type dt = std::min (std::max (arg[0], times_[i]), times_[i+1])
+                - times_[i];
+              result.vector() = (se3_->elementConstRef(q0_.col(i))
+                  + dt * v_.col(i)).vector();
+            }
+
+            void impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const
+            {
+              jacobian.col(0) = v_.col(segment (arg[0]));
+            }
+
+          private:
+            FunctionFromSE3Segments (size_type N)
+              : DifferentiableFunction (1, 1, LiegroupSpace::R3xSO3()),
+              se3_ (LiegroupSpace::SE3()),
+              times_ (N+1), q0_ (7, N), v_ (6, N), grid_ (N, 0), gridStep_ (0)
+            {}
+
+            bool initialize (const core::PathVectorPtr_t& pv)
+            {
+              const size_type N = q0_.cols();
+              times_[0] = pv->timeRange().first;
+              for (size_type i = 0; i < N; ++i) {
+                PathPtr_t p (pv->pathAtRank (i));
+                if (!HPP_DYNAMIC_PTR_CAST (core::StraightPath, p)
+                    || p->constraints() || p->timeParameterization())
+                  return false;
+                q0_.col(i) = p->initial();
+                times_[i+1] = times_[i] + p->length();
+                if (p->length() > 0)
+                  v_.col(i) = (se3_->elementConstRef(p->end())
+                      - se3_->elementConstRef(q0_.col(i))) / p->length();
+                else
+                  v_.col(i).setZero();
+              }
+
+              // Index of the segment at the beginning of each grid cell.
+              gridStep_ = (times_[N] - times_[0]) / (value_type)N;
+              size_type i = 0;
+              for (size_type k = 0; k < N; ++k) {
+                value_type t = times_[0] + (value_type)k * gridStep_;
+                while (i < N-1 && t >= times_[i+1]) ++i;
+                grid_[k] = i;
+              }
+
+              // Check the table against the path in the middle of each
+              // segment. This rejects straight paths that do not
+              // interpolate in SE(3).
+              vector_t qRef (7), arg (1);
+              for (size_type i = 0; i < N; ++i) {
+                arg[0] = .5 * (times_[i] + times_[i+1]);
+                LiegroupElement value ((*this) (arg));
+                if (!(*pv) (qRef, arg[0])) return false;
+                if ((se3_->elementConstRef(qRef)
+                      - se3_->elementConstRef(value.vector())).norm() > 1e-8) {
+                  hppDout (info, "Segment " << i << " does not interpolate in"
+                      " SE(3).");
+                  return false;
+                }
+              }
+              return true;
+            }
+
+            size_type segment (const value_type& t) const
+            {
+              const size_type N = q0_.cols();
+              if (t <= times_[0]) return 0;
+              if (t >= times_[N]) return N-1;
+              size_type k = std::min ((size_type)((t - times_[0]) / gridStep_),
+                  N-1);
+              size_type i = grid_[k];
+              while (i < N-1 && t >= times_[i+1]) ++i;
+              return i;
+            }
+
+            LiegroupSpacePtr_t se3_;
+            /// Boundaries of the segments.
+            vector_t times_;
+            /// Initial pose and velocity of each segment.
+            matrix_t q0_, v_;
+            std::vector<size_type> grid_;
+            value_type gridStep_;
+        };
       }
 
       PathPtr_t EndEffectorTrajectory::makePiecewiseLinearTrajectory (
@@ -118,6 +237,21 @@ namespace hpp {
 
       void EndEffectorTrajectory::trajectory (const PathPtr_t& eeTraj, bool se3Output)
       {
+        trajectory (eeTraj, se3Output, false);
+      }
+
+      void EndEffectorTrajectory::trajectory (const PathPtr_t& eeTraj,
+          bool se3Output, bool precompute)
+      {
+        if (se3Output && precompute) {
+          DifferentiableFunctionPtr_t f (FunctionFromSE3Segments::create (eeTraj));
+          if (f) {
+            trajectory (f, eeTraj->timeRange());
+            return;
+          }
+          hppDout (info, "Trajectory is not piecewise linear in SE(3). "
+              "Evaluating the path directly.");
+        }
         if (se3Output)
           trajectory (DifferentiableFunctionPtr_t
               (new FunctionFromPath <true > (eeTraj)), eeTraj->timeRange());
@@ -163,9 +297,9 @@ namespace hpp {
         core::ConstraintSetPtr_t c (getUpdatedConstraints());
 
         size_type N = configs.cols();
-        if (timeRange_.first != times[0] || timeRange_.second != times[N-1]) {
+        if (timeRange_.first > times[0] || timeRange_.second < times[N-1]) {
           HPP_THROW (std::logic_error, "Time range (" << timeRange_.first <<
-              ", " << timeRange_.second << ") does not match configuration "
+              ", " << timeRange_.second << ") does not contain configuration "
               "times (" << times[0] << ", " << times[N-1]);
         }
 
@@ -173,7 +307,8 @@ namespace hpp {
         using core::InterpolatedPathPtr_t;
 
         InterpolatedPathPtr_t path = InterpolatedPath::create
-	  (problem()->robot(), configs.col(0), configs.col(N-1), timeRange_, c);
+	  (problem()->robot(), configs.col(0), configs.col(N-1),
+           interval_t (times[0], times[N-1]), c);
 
         for (size_type i = 1; i < configs.cols()-1; ++i)
           path->insert(times[i], configs.col(i));
@@ -18,6 +18,12 @@
 
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/weak_ptr.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <cmath>
+
+#include <pinocchio/multibody/model.hpp>
 
 #include <hpp/util/debug.hh>
 #include <hpp/util/serialization.hh>
@@ -54,15 +60,194 @@ namespace hpp {
       return createCopy (weak_.lock ());
     }
 
+    namespace {
+      enum JointType {
+        VECTOR_SPACE,
+        SO2,
+        SO3,
+        R2xSO2,
+        R3xSO3,
+        UNSUPPORTED
+      };
+
+      /// Whether one of the indices in [i, i+n[ belongs to one of the
+      /// segments.
+      bool isInSegments (const core::segments_t& segments, size_type i,
+          size_type n)
+      {
+        for (std::size_t k = 0; k < segments.size(); ++k)
+          if (segments[k].first < i + n
+              && i < segments[k].first + segments[k].second)
+            return true;
+        return false;
+      }
+
+      /// Type of a joint for method distances.
+      struct JointTypeVisitor : boost::static_visitor <int>
+      {
+        template <typename JointModel>
+        int operator() (const JointModel& joint) const
+        {
+          return (joint.nq () == joint.nv () ? VECTOR_SPACE : UNSUPPORTED);
+        }
+        template <int axis>
+        int operator() (const ::pinocchio::JointModelRevoluteUnboundedTpl
+            <value_type, 0, axis>&) const
+        {
+          return SO2;
+        }
+        int operator() (const ::pinocchio::JointModelRevoluteUnboundedUnaligned&)
+          const
+        {
+          return SO2;
+        }
+        int operator() (const ::pinocchio::JointModelSpherical&) const
+        {
+          return SO3;
+        }
+        int operator() (const ::pinocchio::JointModelPlanar&) const
+        {
+          return R2xSO2;
+        }
+        int operator() (const ::pinocchio::JointModelFreeFlyer&) const
+        {
+          return R3xSO3;
+        }
+      };
+
+      /// Add the squared rotation angle of the SO(2) joint at rank r.
+      void addSquaredAngleSO2 (ConfigurationIn_t q, matrixIn_t configs,
+          size_type r, value_type w2, vectorOut_t sq)
+      {
+        typedef Eigen::Array <value_type, 1, Eigen::Dynamic> RowArray_t;
+        // Cosine and sine of the angles, up to the same positive factor.
+        const RowArray_t
+          c (q[r  ] * configs.row (r  ).array()
+           + q[r+1] * configs.row (r+1).array()),
+          s (q[r  ] * configs.row (r+1).array()
+           - q[r+1] * configs.row (r  ).array());
+        sq.array() += w2 * s.binaryExpr (c, [] (value_type y, value_type x)
+            { return std::atan2 (y, x); }).square().transpose();
+      }
+
+      /// Add the squared rotation angle of the SO(3) joint at rank r.
+      void addSquaredAngleSO3 (ConfigurationIn_t q, matrixIn_t configs,
+          size_type r, value_type w2, vectorOut_t sq)
+      {
+        const vector_t dots
+          (configs.middleRows (r, 4).transpose() * q.segment (r, 4));
+        sq.array() += 4 * w2 * dots.array().abs().min ((value_type)1).acos()
+          .square();
+      }
+
+      /// Add the squared norm of the difference of the vector space
+      /// joint at rank r.
+      void addSquaredNormRn (ConfigurationIn_t q, matrixIn_t configs,
+          size_type r, size_type n, value_type w2, vectorOut_t sq)
+      {
+        sq += w2 * (configs.middleRows (r, n).colwise() - q.segment (r, n))
+          .colwise().squaredNorm().transpose();
+      }
+    }
+
     WeighedDistance::WeighedDistance (const DevicePtr_t& robot,
         const graph::GraphPtr_t graph) :
-      core::WeighedDistance (robot), graph_ (graph)
+      core::WeighedDistance (robot), graph_ (graph), batch_ (true)
     {
+      initSegments (robot);
     }
 
     WeighedDistance::WeighedDistance (const WeighedDistance& distance) :
-      core::WeighedDistance (distance), graph_ (distance.graph_)
+      core::WeighedDistance (distance), graph_ (distance.graph_),
+      segments_ (distance.segments_), batch_ (distance.batch_)
+    {
+    }
+
+    void WeighedDistance::initSegments (const DevicePtr_t& robot)
     {
+      const pinocchio::Model& model = robot->model();
+      segments_.resize (model.joints.size() - 1);
+      for (std::size_t i = 1; i < model.joints.size(); ++i) {
+        Segment& s (segments_[i-1]);
+        s.rank = model.joints[i].idx_q();
+        s.size = model.joints[i].nq();
+        s.rankV = model.joints[i].idx_v();
+        s.sizeV = model.joints[i].nv();
+        s.type = boost::apply_visitor (JointTypeVisitor (),
+            model.joints[i].toVariant());
+        if (s.type == UNSUPPORTED) {
+          hppDout (info, "Joint " << model.names[i] << " of type "
+              << model.joints[i].shortname()
+              << " is not supported by WeighedDistance::distances");
+          batch_ = false;
+        }
+      }
+    }
+
+    void WeighedDistance::squaredDistances (ConfigurationIn_t q,
+        matrixIn_t configs, const Eigen::ColBlockIndices* dofs,
+        vectorOut_t sq) const
+    {
+      for (std::size_t j = 0; j < segments_.size(); ++j) {
+        const Segment& s (segments_[j]);
+        if (dofs != NULL && !isInSegments (dofs->indices(), s.rankV, s.sizeV))
+          continue;
+        value_type w2 = getWeight (j) * getWeight (j);
+        switch (s.type) {
+          case VECTOR_SPACE:
+            addSquaredNormRn (q, configs, s.rank, s.size, w2, sq);
+            break;
+          case SO2:
+            addSquaredAngleSO2 (q, configs, s.rank, w2, sq);
+            break;
+          case SO3:
+            addSquaredAngleSO3 (q, configs, s.rank, w2, sq);
+            break;
+          case R2xSO2:
+            addSquaredNormRn (q, configs, s.rank, 2, w2, sq);
+            addSquaredAngleSO2 (q, configs, s.rank + 2, w2, sq);
+            break;
+          case R3xSO3:
+            addSquaredNormRn (q, configs, s.rank, 3, w2, sq);
+            addSquaredAngleSO3 (q, configs, s.rank + 3, w2, sq);
+            break;
+        }
+      }
+      // Extra configuration space
+      size_type n = q.size() - (segments_.empty() ? 0 :
+          segments_.back().rank + segments_.back().size);
+      if (n > 0) addSquaredNormRn (q, configs, q.size() - n, n, 1, sq);
+    }
+
+    void WeighedDistance::distances (ConfigurationIn_t q, matrixIn_t configs,
+        vectorOut_t result) const
+    {
+      assert (result.size() == configs.cols());
+      if (!batch_) {
+        for (size_type i = 0; i < configs.cols(); ++i)
+          result[i] = (*this) (q, configs.col(i));
+        return;
+      }
+
+      vector_t sq (vector_t::Zero (configs.cols()));
+      squaredDistances (q, configs, NULL, sq);
+      result = sq.cwiseSqrt();
+    }
+
+    void WeighedDistance::distances (ConfigurationIn_t q, matrixIn_t configs,
+        const Eigen::ColBlockIndices& dofs, vectorOut_t result) const
+    {
+      assert (result.size() == configs.cols());
+      if (!batch_) {
+        hppDout (warning, "WeighedDistance::distances cannot be restricted "
+            "to a subset of the degrees of freedom. Using all of them.");
+        distances (q, configs, result);
+        return;
+      }
+
+      vector_t sq (vector_t::Zero (configs.cols()));
+      squaredDistances (q, configs, &dofs, sq);
+      result = sq.cwiseSqrt();
     }
 
     void WeighedDistance::init (WeighedDistanceWkPtr_t self)
@@ -14,11 +14,19 @@
 // received a copy of the GNU Lesser General Public License along with
 // hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <sstream>
+
 #include <hpp/pinocchio/urdf/util.hh>
 #include <hpp/pinocchio/liegroup-element.hh>
 
 #include <hpp/core/steering-method/straight.hh>
 #include <hpp/core/path-validation-report.hh>
+#include <hpp/core/config-projector.hh>
+#include <hpp/core/path-optimizer.hh>
+#include <hpp/core/path-vector.hh>
+#include <hpp/core/edge.hh>
+#include <hpp/core/path-validation/discretized-joint-bound.hh>
 
 #include <hpp/constraints/generic-transformation.hh>
 #include <hpp/constraints/locked-joint.hh>
@@ -28,10 +36,19 @@
 #include "hpp/manipulation/graph/state.hh"
 #include "hpp/manipulation/graph/state-selector.hh"
 #include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/graph/statistics.hh"
 #include "hpp/manipulation/graph/edge.hh"
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/problem.hh"
+#include "hpp/manipulation/roadmap.hh"
+#include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/connected-component.hh"
+#include "hpp/manipulation/weighed-distance.hh"
+#include "hpp/manipulation/graph-optimizer.hh"
 #include "hpp/manipulation/graph-path-validation.hh"
+#include "hpp/manipulation/manipulation-planner.hh"
+#include "hpp/manipulation/lazy-path.hh"
+#include "hpp/manipulation/reversed-path.hh"
 #include <hpp/manipulation/steering-method/graph.hh>
 
 #include <boost/test/unit_test.hpp>
@@ -174,3 +191,822 @@ BOOST_AUTO_TEST_CASE (Initialization)
     }
   }
 }
+
+namespace hpp_test {
+  using hpp::core::vector_t;
+  using hpp::constraints::ImplicitPtr_t;
+  using hpp::manipulation::graph::WaypointEdge;
+  using hpp::manipulation::graph::WaypointEdgePtr_t;
+
+  /// q[0]^2 - 0.25, whose jacobian vanishes at q[0] = 0.
+  class SquaredVariable : public hpp::constraints::DifferentiableFunction
+  {
+    public:
+      SquaredVariable (const hpp::manipulation::DevicePtr_t& robot) :
+        DifferentiableFunction (robot->configSize (), robot->numberDof (),
+            hpp::pinocchio::LiegroupSpace::R1 (), "SquaredVariable")
+      {}
+
+    protected:
+      void impl_compute (hpp::pinocchio::LiegroupElementRef result,
+          hpp::core::vectorIn_t arg) const
+      {
+        result.vector ()[0] = arg[0] * arg[0] - 0.25;
+      }
+
+      void impl_jacobian (hpp::core::matrixOut_t jacobian,
+          hpp::core::vectorIn_t arg) const
+      {
+        jacobian.setZero ();
+        jacobian (0, 0) = 2 * arg[0];
+      }
+  };
+
+  /// Value of one configuration variable.
+  class VariableValue : public hpp::constraints::DifferentiableFunction
+  {
+    public:
+      VariableValue (const hpp::manipulation::DevicePtr_t& robot,
+          hpp::core::size_type index) :
+        DifferentiableFunction (robot->configSize (), robot->numberDof (),
+            hpp::pinocchio::LiegroupSpace::R1 (), "VariableValue"),
+        index_ (index)
+      {}
+
+    protected:
+      void impl_compute (hpp::pinocchio::LiegroupElementRef result,
+          hpp::core::vectorIn_t arg) const
+      {
+        result.vector ()[0] = arg[index_];
+      }
+
+      void impl_jacobian (hpp::core::matrixOut_t jacobian,
+          hpp::core::vectorIn_t) const
+      {
+        jacobian.setZero ();
+        jacobian (0, index_) = 1;
+      }
+
+    private:
+      hpp::core::size_type index_;
+  };
+
+  /// Path optimizer that counts its calls and returns the input path.
+  class CountingOptimizer : public hpp::core::PathOptimizer
+  {
+    public:
+      static std::size_t nbCalls;
+
+      static hpp::core::PathOptimizerPtr_t create
+      (const hpp::core::ProblemConstPtr_t& problem)
+      {
+        return hpp::core::PathOptimizerPtr_t (new CountingOptimizer (problem));
+      }
+
+      hpp::core::PathVectorPtr_t optimize
+      (const hpp::core::PathVectorPtr_t& path)
+      {
+        ++nbCalls;
+        return path;
+      }
+
+    protected:
+      CountingOptimizer (const hpp::core::ProblemConstPtr_t& problem) :
+        PathOptimizer (problem)
+      {}
+  };
+
+  std::size_t CountingOptimizer::nbCalls = 0;
+
+  /// UR5 robot, a problem and a constraint graph with a state selector and
+  /// no state.
+  struct UR5Graph
+  {
+    hpp::manipulation::DevicePtr_t robot;
+    hpp::manipulation::ProblemPtr_t problem;
+    GraphPtr_t graph;
+    StateSelectorPtr_t selector;
+
+    UR5Graph ()
+    {
+      robot = hpp::manipulation::Device::create ("test-robot");
+      hpp::pinocchio::urdf::loadModel
+        (robot, 0, "ur5/", "anchor",
+         "package://example-robot-data/robots/ur_description/urdf/"
+         "ur5_joint_limited_robot.urdf",
+         "package://example-robot-data/robots/ur_description/srdf/"
+         "ur5_joint_limited_robot.srdf");
+      problem = hpp::manipulation::Problem::create (robot);
+      graph = Graph::create ("graph", robot, problem);
+      graph->maxIterations (20);
+      graph->errorThreshold (1e-4);
+      selector = graph->createStateSelector ("node-selector");
+    }
+
+    /// Lock a joint of the robot at a given value.
+    ImplicitPtr_t lockedJoint (std::size_t index,
+        hpp::core::value_type value) const
+    {
+      using hpp::pinocchio::LiegroupElement;
+      using hpp::pinocchio::LiegroupSpace;
+      return hpp::constraints::LockedJoint::create (robot->jointAt (index),
+          LiegroupElement (vector_t::Constant (1, value),
+            LiegroupSpace::R1 (true)));
+    }
+
+    /// Constraint on the value of one configuration variable.
+    ImplicitPtr_t variableValue (hpp::core::size_type index,
+        hpp::constraints::ComparisonType type) const
+    {
+      return hpp::constraints::Implicit::create
+        (hpp::constraints::DifferentiableFunctionPtr_t
+         (new VariableValue (robot, index)),
+         hpp::constraints::ComparisonTypes_t (1, type));
+    }
+  };
+
+  /// UR5Graph with a waypoint transition from node 1 to node 2 through a
+  /// waypoint state, built by initializeWaypointGraph.
+  struct WaypointGraph : UR5Graph
+  {
+    StatePtr_t n1, n2, nw;
+    EdgePtr_t e11, e22;
+    WaypointEdgePtr_t we;
+
+    /// \param waypoint constraint of the waypoint state. Node 2 is included
+    ///        in the waypoint state, with joint 1 locked at 0.5.
+    void initializeWaypointGraph (const ImplicitPtr_t& waypoint)
+    {
+      n2 = selector->createState ("node 2");
+      n2->addNumericalConstraint (waypoint);
+      n2->addNumericalConstraint (lockedJoint (1, 0.5));
+      nw = selector->createState ("waypoint", true);
+      nw->addNumericalConstraint (waypoint);
+      n1 = selector->createState ("node 1");
+      e11 = n1->linkTo ("edge 11", n1);
+      e22 = n2->linkTo ("edge 22", n2);
+      we = HPP_STATIC_PTR_CAST (WaypointEdge,
+          n1->linkTo ("edge 12", n2, 1, WaypointEdge::create));
+      we->nbWaypoints (1);
+      EdgePtr_t e1w (n1->linkTo ("edge 1w", nw, -1)),
+                ew2 (nw->linkTo ("edge w2", n2, -1));
+      e1w->state (n1);
+      ew2->state (nw);
+      we->setWaypoint (0, e1w, nw);
+      we->setWaypoint (1, ew2, n2);
+      graph->initialize ();
+    }
+  };
+} // namespace hpp_test
+
+BOOST_FIXTURE_TEST_CASE (WaypointCache, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  initializeWaypointGraph (lockedJoint (0, 0.3));
+
+  Configuration_t q1 (Configuration_t::Zero (6)), q2 (q1), q3 (q1), q4 (q1);
+  q2[2] = 0.2;
+  q3[2] = 0.4;
+  q4[2] = 0.6;
+  PathPtr_t path;
+
+  // build after generateTargetConfig finds the waypoints in the cache.
+  BOOST_REQUIRE (we->generateTargetConfig (q1, q2));
+  BOOST_CHECK_CLOSE (q2[0], 0.3, 1e-6);
+  BOOST_CHECK_CLOSE (q2[1], 0.5, 1e-6);
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  BOOST_CHECK_EQUAL (we->nbCacheHits (), 1);
+  BOOST_CHECK_EQUAL (we->nbCacheMisses (), 0);
+  BOOST_CHECK (path->initial ().isApprox (q1));
+  BOOST_CHECK (path->end ().isApprox (q2));
+
+  // Other end configuration: not in the cache, but stored by build.
+  q3[0] = 0.3;
+  q3[1] = 0.5;
+  BOOST_REQUIRE (we->build (path, q1, q3));
+  BOOST_CHECK_EQUAL (we->nbCacheMisses (), 1);
+  BOOST_REQUIRE (we->build (path, q1, q3));
+  BOOST_CHECK_EQUAL (we->nbCacheHits (), 2);
+  // The entry of q2 is still in the cache.
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  BOOST_CHECK_EQUAL (we->nbCacheHits (), 3);
+
+  // The least recently used entries are evicted.
+  we->waypointCacheSize (1);
+  BOOST_REQUIRE (we->generateTargetConfig (q1, q4));
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  BOOST_CHECK_EQUAL (we->nbCacheMisses (), 2);
+  BOOST_REQUIRE (we->build (path, q1, q4));
+  BOOST_CHECK_EQUAL (we->nbCacheMisses (), 3);
+
+  // Disabled cache
+  we->waypointCacheSize (0);
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  BOOST_CHECK_EQUAL (we->nbCacheHits (), 3);
+  BOOST_CHECK_EQUAL (we->nbCacheMisses (), 5);
+}
+
+BOOST_FIXTURE_TEST_CASE (WaypointLocalRestarts, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  using hpp::constraints::Implicit;
+  using hpp::constraints::ComparisonTypes_t;
+  initializeWaypointGraph (Implicit::create
+      (hpp::constraints::DifferentiableFunctionPtr_t
+       (new SquaredVariable (robot)),
+       ComparisonTypes_t (1, hpp::constraints::EqualToZero)));
+
+  // The projection of the waypoints cannot start from q[0] = 0.
+  Configuration_t q1 (Configuration_t::Zero (6)), q (q1);
+  BOOST_CHECK (!we->generateTargetConfig (q1, q));
+
+  we->nbLocalRestarts (10);
+  q = q1;
+  BOOST_REQUIRE (we->generateTargetConfig (q1, q));
+  BOOST_CHECK_CLOSE (std::abs (q[0]), 0.5, 0.1);
+  BOOST_CHECK_CLOSE (q[1], 0.5, 1e-6);
+}
+
+BOOST_FIXTURE_TEST_CASE (WaypointParallelBuild, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  using hpp::core::PathVector;
+  using hpp::core::PathVectorPtr_t;
+  initializeWaypointGraph (lockedJoint (0, 0.3));
+  we->waypointCacheSize (0);
+
+  Configuration_t q1 (Configuration_t::Zero (6)), q2 (q1);
+  q2[2] = 0.2;
+  BOOST_REQUIRE (we->generateTargetConfig (q1, q2));
+
+  PathPtr_t sequential, parallel;
+  BOOST_REQUIRE (we->build (sequential, q1, q2));
+  we->parallelBuild (true);
+  BOOST_REQUIRE (we->build (parallel, q1, q2));
+
+  PathVectorPtr_t pvs (HPP_DYNAMIC_PTR_CAST (PathVector, sequential)),
+                  pvp (HPP_DYNAMIC_PTR_CAST (PathVector, parallel));
+  BOOST_REQUIRE (pvs && pvp);
+  BOOST_CHECK_EQUAL (pvs->numberPaths (), 2);
+  BOOST_REQUIRE_EQUAL (pvp->numberPaths (), pvs->numberPaths ());
+  for (std::size_t i = 0; i < pvs->numberPaths (); ++i) {
+    BOOST_CHECK (pvp->pathAtRank (i)->initial ().isApprox
+        (pvs->pathAtRank (i)->initial ()));
+    BOOST_CHECK (pvp->pathAtRank (i)->end ().isApprox
+        (pvs->pathAtRank (i)->end ()));
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE (LeafHistogramLazyInsertion, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::ConfigProjector;
+  using hpp::core::ConfigProjectorPtr_t;
+  using hpp::manipulation::ConstraintSet;
+  using hpp::manipulation::ConstraintSetPtr_t;
+  using hpp::manipulation::RoadmapNode;
+  using hpp::manipulation::RoadmapNodePtr_t;
+  using hpp::manipulation::graph::Foliation;
+  using hpp::manipulation::graph::LeafHistogram;
+  using hpp::manipulation::graph::LeafHistogramPtr_t;
+
+  // Foliation q1 = 0 parameterized by q0.
+  ConstraintSetPtr_t condition (ConstraintSet::create (robot, "condition")),
+                     parametrizer (ConstraintSet::create (robot, "param"));
+  ConfigProjectorPtr_t proj (ConfigProjector::create (robot, "projCond",
+        1e-4, 20));
+  proj->add (variableValue (1, hpp::constraints::EqualToZero));
+  condition->addConstraint (proj);
+  proj = ConfigProjector::create (robot, "projParam", 1e-4, 20);
+  proj->add (variableValue (0, hpp::constraints::Equality));
+  parametrizer->addConstraint (proj);
+  Foliation f;
+  f.condition (condition);
+  f.parametrizer (parametrizer);
+  LeafHistogramPtr_t hist (LeafHistogram::create (f));
+
+  std::vector <RoadmapNodePtr_t> nodes;
+  const double values[4][2] = { { 0, 0 }, { 0, 0 }, { 1, 0 }, { 0, 1 } };
+  for (std::size_t i = 0; i < 4; ++i) {
+    Configuration_t q (Configuration_t::Zero (6));
+    q[0] = values[i][0];
+    q[1] = values[i][1];
+    nodes.push_back (new RoadmapNode (hpp::core::ConfigurationPtr_t
+          (new Configuration_t (q))));
+    hist->add (nodes.back ());
+  }
+
+  // Nodes are inserted when the histogram is read.
+  BOOST_CHECK_EQUAL (hist->nbPendingNodes (), 4);
+  BOOST_CHECK_EQUAL (hist->numberOfObservations (), 0);
+  BOOST_CHECK_EQUAL (hist->getDistrib ().totalWeight (), 3);
+  BOOST_CHECK_EQUAL (hist->nbPendingNodes (), 0);
+  BOOST_CHECK_EQUAL (hist->numberOfObservations (), 3);
+  BOOST_CHECK_EQUAL (hist->getDistrib ().values ().size (), 2);
+
+  // Pending nodes are dropped by clear.
+  hist->add (nodes.front ());
+  hist->clear ();
+  BOOST_CHECK_EQUAL (hist->nbPendingNodes (), 0);
+  BOOST_CHECK_EQUAL (hist->getDistrib ().totalWeight (), 0);
+
+  // The queue is bounded.
+  for (std::size_t i = 0; i < LeafHistogram::maxPendingNodes; ++i)
+    hist->add (nodes.front ());
+  BOOST_CHECK_EQUAL (hist->nbPendingNodes (), 0);
+  BOOST_CHECK_EQUAL (hist->numberOfObservations (),
+      LeafHistogram::maxPendingNodes);
+
+  for (std::size_t i = 0; i < nodes.size (); ++i) delete nodes[i];
+}
+
+BOOST_FIXTURE_TEST_CASE (SharedLeafHistograms, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::constraints::Equality;
+  using hpp::constraints::EqualToZero;
+  using hpp::manipulation::graph::LevelSetEdge;
+  using hpp::manipulation::graph::LevelSetEdgePtr_t;
+  using hpp::manipulation::graph::LeafHistogramPtr_t;
+  StatePtr_t n1 (selector->createState ("node 1")),
+             n2 (selector->createState ("node 2"));
+
+  // Edges 0 and 1 define the same foliation.
+  ImplicitPtr_t condition (variableValue (1, EqualToZero)),
+                param (variableValue (0, Equality)),
+                other (variableValue (2, Equality));
+  LevelSetEdgePtr_t edges[3];
+  for (std::size_t i = 0; i < 3; ++i) {
+    std::ostringstream name;
+    name << "level set " << i;
+    edges[i] = HPP_STATIC_PTR_CAST (LevelSetEdge,
+        n1->linkTo (name.str (), n2, 1, LevelSetEdge::create));
+    edges[i]->insertConditionConstraint (condition);
+  }
+  edges[0]->insertParamConstraint (param);
+  edges[1]->insertParamConstraint (param);
+  edges[2]->insertParamConstraint (other);
+  graph->initialize ();
+
+  LeafHistogramPtr_t shared (edges[0]->histogram ());
+  BOOST_REQUIRE (shared);
+  BOOST_CHECK (edges[1]->histogram () == shared);
+  BOOST_REQUIRE (edges[2]->histogram ());
+  BOOST_CHECK (edges[2]->histogram () != shared);
+  BOOST_CHECK_EQUAL (graph->histograms ().size (), 2);
+  // The shared foliation does not belong to any edge.
+  BOOST_CHECK (!shared->foliation ().parametrizer ()->edge ());
+
+  // A histogram still used by another edge is kept.
+  edges[1]->insertParamConstraint (other);
+  edges[1]->buildHistogram ();
+  BOOST_CHECK (edges[1]->histogram () != shared);
+  BOOST_CHECK (edges[0]->histogram () == shared);
+  BOOST_CHECK_EQUAL (graph->histograms ().size (), 3);
+
+  // A histogram used by no edge is removed.
+  LeafHistogramPtr_t unused (edges[2]->histogram ());
+  edges[2]->insertParamConstraint (param);
+  edges[2]->buildHistogram ();
+  BOOST_CHECK (edges[2]->histogram () != unused);
+  BOOST_CHECK_EQUAL (graph->histograms ().size (), 3);
+  BOOST_CHECK (std::find (graph->histograms ().begin (),
+        graph->histograms ().end (), unused) == graph->histograms ().end ());
+}
+
+BOOST_FIXTURE_TEST_CASE (ReversedWaypointPath, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  using hpp::core::PathVector;
+  using hpp::core::PathVectorPtr_t;
+  using hpp::manipulation::ConstraintSet;
+  using hpp::manipulation::ConstraintSetPtr_t;
+  using hpp::manipulation::GraphOptimizer;
+  using hpp::manipulation::ReversedPath;
+  initializeWaypointGraph (lockedJoint (0, 0.3));
+
+  Configuration_t q1 (Configuration_t::Zero (6)), q2 (q1);
+  q2[2] = 0.2;
+  BOOST_REQUIRE (we->generateTargetConfig (q1, q2));
+  PathPtr_t path;
+  BOOST_REQUIRE (we->build (path, q1, q2));
+  PathPtr_t reversed (ReversedPath::reverse (path));
+
+  // The sub-paths are reversed, in reverse order.
+  PathVectorPtr_t pv (HPP_DYNAMIC_PTR_CAST (PathVector, reversed));
+  BOOST_REQUIRE (pv);
+  BOOST_REQUIRE_EQUAL (pv->numberPaths (), 2);
+  const hpp::core::value_type L (path->length ());
+  BOOST_CHECK_CLOSE (reversed->length (), L, 1e-8);
+  for (int i = 0; i <= 10; ++i) {
+    bool success;
+    Configuration_t q (path->eval (L * i / 10., success)),
+                    qr (reversed->eval (L - L * i / 10., success));
+    BOOST_CHECK (q.isApprox (qr, 1e-8));
+  }
+  const EdgePtr_t edges[2] = { we->waypoint (1), we->waypoint (0) };
+  for (std::size_t i = 0; i < 2; ++i) {
+    ConstraintSetPtr_t c (HPP_DYNAMIC_PTR_CAST (ConstraintSet,
+          pv->pathAtRank (i)->constraints ()));
+    BOOST_REQUIRE (c);
+    BOOST_CHECK (c->edge () == edges[i]);
+  }
+
+  // Reversing again gives the original sub-paths.
+  PathVectorPtr_t original (HPP_DYNAMIC_PTR_CAST (PathVector, path)),
+    twice (HPP_DYNAMIC_PTR_CAST (PathVector, ReversedPath::reverse (reversed)));
+  BOOST_REQUIRE (original && twice);
+  BOOST_REQUIRE_EQUAL (twice->numberPaths (), 2);
+  for (std::size_t i = 0; i < 2; ++i)
+    BOOST_CHECK (twice->pathAtRank (i) == original->pathAtRank (i));
+
+  // The graph optimizer optimizes each transition separately.
+  PathVectorPtr_t input (PathVector::create (reversed->outputSize (),
+        reversed->outputDerivativeSize ()));
+  input->appendPath (reversed);
+  CountingOptimizer::nbCalls = 0;
+  PathVectorPtr_t opted (GraphOptimizer::create <CountingOptimizer> (problem)
+      ->optimize (input));
+  BOOST_CHECK_EQUAL (CountingOptimizer::nbCalls, 2);
+  BOOST_CHECK (opted->initial ().isApprox (q2));
+  BOOST_CHECK (opted->end ().isApprox (q1));
+}
+
+BOOST_FIXTURE_TEST_CASE (LazyPathCheck, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  using hpp::core::interval_t;
+  using hpp::manipulation::LazyPath;
+  using hpp::manipulation::LazyPathPtr_t;
+  using hpp::manipulation::LazyPathCache;
+  using hpp::manipulation::LazyPathCachePtr_t;
+  initializeWaypointGraph (lockedJoint (0, 0.3));
+
+  Configuration_t q1 (Configuration_t::Zero (6)), q2 (q1), q3 (q1);
+  q2[2] = 0.2;
+  q3[3] = 0.3;
+  PathPtr_t p12, p13;
+  BOOST_REQUIRE (e11->build (p12, q1, q2));
+  BOOST_REQUIRE (e11->build (p13, q1, q3));
+
+  LazyPathCachePtr_t cache (LazyPathCache::create (1));
+  LazyPathPtr_t l12 (LazyPath::create (e11, q1, q2, p12->timeRange (), cache)),
+                l13 (LazyPath::create (e11, q1, q3, p13->timeRange (), cache));
+  BOOST_CHECK_EQUAL (cache->nbBuiltPaths (), 0);
+  BOOST_CHECK (l12->path ()->end ().isApprox (q2));
+  BOOST_CHECK (l13->path ()->end ().isApprox (q3));
+  BOOST_CHECK (l12->path ()->end ().isApprox (q2));
+  BOOST_CHECK_EQUAL (cache->nbBuiltPaths (), 1);
+  l12.reset ();
+  BOOST_CHECK_EQUAL (cache->nbBuiltPaths (), 0);
+
+  // A path built with another time range is rejected.
+  LazyPathPtr_t wrong (LazyPath::create (e11, q1, q2,
+        interval_t (0, 2 * p12->length ()), cache));
+  BOOST_CHECK_THROW (wrong->path (), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE (ReducedStateMetric, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  using hpp::core::ConfigurationPtr_t;
+  using hpp::manipulation::ConnectedComponent;
+  using hpp::manipulation::ConnectedComponentPtr_t;
+  using hpp::manipulation::ReversedPath;
+  using hpp::manipulation::Roadmap;
+  using hpp::manipulation::RoadmapPtr_t;
+  using hpp::manipulation::RoadmapNodePtr_t;
+  using hpp::manipulation::WeighedDistance;
+  using hpp::manipulation::WeighedDistancePtr_t;
+  StatePtr_t n1 (selector->createState ("locked"));
+  n1->addNumericalConstraint (lockedJoint (0, 0.3));
+  StatePtr_t n2 (selector->createState ("free"));
+  EdgePtr_t e11 (n1->linkTo ("edge 11", n1));
+  graph->initialize ();
+
+  // Joint 0 is an output of the locked joint.
+  BOOST_CHECK_EQUAL (n1->freeVelocityVariables ().nbCols (), 5);
+  BOOST_CHECK_EQUAL (n1->freeConfigurationVariables ().nbRows (), 5);
+  BOOST_CHECK_EQUAL (n2->freeVelocityVariables ().nbCols (), 6);
+
+  WeighedDistancePtr_t distance (WeighedDistance::create (robot, graph));
+  RoadmapPtr_t roadmap (Roadmap::create (distance, robot));
+  roadmap->constraintGraph (graph);
+  ConfigurationPtr_t qa (new Configuration_t (Configuration_t::Zero (6))),
+                     qb (new Configuration_t (Configuration_t::Zero (6)));
+  (*qa)[0] = (*qb)[0] = 0.3;
+  (*qa)[1] = 0.1;
+  (*qb)[1] = 0.5;
+  PathPtr_t path;
+  BOOST_REQUIRE (e11->build (path, *qa, *qb));
+  hpp::core::NodePtr_t na (roadmap->addNode (qa)), nb (roadmap->addNode (qb));
+  roadmap->addEdge (na, nb, path);
+  roadmap->addEdge (nb, na, ReversedPath::reverse (path));
+  ConnectedComponentPtr_t cc (HPP_STATIC_PTR_CAST (ConnectedComponent,
+        na->connectedComponent ()));
+  BOOST_REQUIRE_EQUAL (cc->getRoadmapNodes (n1).size (), 2);
+  // The configurations are kept when the connected components merge.
+  BOOST_REQUIRE_EQUAL (cc->getConfigurations (n1).cols (), 2);
+  for (std::size_t k = 0; k < 2; ++k)
+    BOOST_CHECK (cc->getConfigurations (n1).col (k) ==
+        *cc->getRoadmapNodes (n1)[k]->configuration ());
+
+  // The query differs from the nodes on joint 0.
+  ConfigurationPtr_t q (new Configuration_t (*qb));
+  (*q)[0] = 1.3;
+  (*q)[1] = 0.45;
+  Configuration_t qInState (*q);
+  qInState[0] = 0.3;
+  hpp::core::value_type d;
+  RoadmapNodePtr_t nearest (roadmap->nearestNodeInState (q, cc, n1, d));
+  BOOST_CHECK (nearest == nb);
+  BOOST_CHECK_CLOSE (d, (*distance) (*q, *qb), 1e-6);
+
+  roadmap->reducedStateMetric (true);
+  nearest = roadmap->nearestNodeInState (q, cc, n1, d);
+  BOOST_CHECK (nearest == nb);
+  BOOST_CHECK_CLOSE (d, (*distance) (qInState, *qb), 1e-6);
+
+  // Same metric with a single node.
+  hpp::core::NodePtr_t nc (roadmap->addNode (ConfigurationPtr_t
+        (new Configuration_t (*qa))));
+  nearest = roadmap->nearestNodeInState (q, HPP_STATIC_PTR_CAST
+      (ConnectedComponent, nc->connectedComponent ()), n1, d);
+  BOOST_CHECK (nearest == nc);
+  BOOST_CHECK_CLOSE (d, (*distance) (qInState, *qa), 1e-6);
+}
+
+BOOST_FIXTURE_TEST_CASE (ExplicitTargetConstraints, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::ConfigProjectorPtr_t;
+  using hpp::core::ConstraintSetPtr_t;
+  StatePtr_t n2 (selector->createState ("locked"));
+  n2->addNumericalConstraint (lockedJoint (0, 0.3));
+  n2->addNumericalConstraint (lockedJoint (2, -0.2));
+  StatePtr_t n1 (selector->createState ("free"));
+  EdgePtr_t e12 (n1->linkTo ("edge 12", n2));
+  graph->initialize ();
+  BOOST_REQUIRE (e12->isTargetExplicit ());
+
+  ConstraintSetPtr_t c (e12->targetConstraint ());
+  ConfigProjectorPtr_t proj (c->configProjector ());
+  Configuration_t qStart (Configuration_t::Zero (6));
+  qStart[1] = 0.4;
+  qStart[3] = -0.5;
+  for (int i = 0; i < 5; ++i) {
+    Configuration_t q (Configuration_t::Random (6)), qApply (q);
+    std::size_t nbSuccess (proj->statistics ().nbSuccess ());
+    BOOST_REQUIRE (e12->generateTargetConfig (qStart, q));
+    BOOST_CHECK_EQUAL (proj->statistics ().nbSuccess (), nbSuccess + 1);
+    BOOST_REQUIRE (c->apply (qApply));
+    BOOST_CHECK (q.isApprox (qApply, 1e-8));
+    BOOST_CHECK_CLOSE (q[0], 0.3, 1e-8);
+    BOOST_CHECK_CLOSE (q[2], -0.2, 1e-8);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE (StateMembershipCache, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::ConfigProjector;
+  using hpp::core::ConfigProjectorPtr_t;
+  using hpp::manipulation::ConstraintSet;
+  using hpp::manipulation::ConstraintSetPtr_t;
+  using hpp::manipulation::graph::Foliation;
+  StatePtr_t n1 (selector->createState ("locked"));
+  n1->addNumericalConstraint (lockedJoint (0, 0.3));
+  StatePtr_t n2 (selector->createState ("free"));
+  graph->initialize ();
+
+  // Repeated and interleaved tests agree with the constraints.
+  Configuration_t qIn (Configuration_t::Zero (6)), qOut (qIn);
+  qIn[0] = 0.3;
+  qIn[1] = 0.5;
+  for (int i = 0; i < 3; ++i) {
+    BOOST_CHECK (n1->contains (qIn));
+    BOOST_CHECK (!n1->contains (qOut));
+    BOOST_CHECK (n2->contains (qIn));
+    BOOST_CHECK (graph->getState (qIn) == n1);
+    BOOST_CHECK (graph->getState (qOut) == n2);
+  }
+
+  // Initializing a state again invalidates the cached results.
+  n1->addNumericalConstraint (lockedJoint (1, 0.7));
+  graph->initialize ();
+  BOOST_CHECK (!n1->contains (qIn));
+  BOOST_CHECK (graph->getState (qIn) == n2);
+  qIn[1] = 0.7;
+  BOOST_CHECK (n1->contains (qIn));
+
+  // Changing the condition of a foliation invalidates the cached results.
+  ConstraintSetPtr_t c2 (ConstraintSet::create (robot, "q2")),
+                     c1 (ConstraintSet::create (robot, "q1"));
+  ConfigProjectorPtr_t proj (ConfigProjector::create (robot, "proj q2",
+        1e-4, 20));
+  proj->add (variableValue (2, hpp::constraints::EqualToZero));
+  c2->addConstraint (proj);
+  proj = ConfigProjector::create (robot, "proj q1", 1e-4, 20);
+  proj->add (variableValue (1, hpp::constraints::EqualToZero));
+  c1->addConstraint (proj);
+  Foliation f;
+  f.condition (c2);
+  BOOST_CHECK (f.contains (qIn));
+  f.condition (c1);
+  BOOST_CHECK (!f.contains (qIn));
+
+  // Changing the error threshold or the right hand side of the constraints
+  // invalidates the cached results.
+  proj->errorThreshold (1.);
+  BOOST_CHECK (f.contains (qIn));
+  ConstraintSetPtr_t c0 (ConstraintSet::create (robot, "q0"));
+  proj = ConfigProjector::create (robot, "proj q0", 1e-4, 20);
+  proj->add (variableValue (0, hpp::constraints::Equality));
+  c0->addConstraint (proj);
+  f.condition (c0);
+  proj->rightHandSideFromConfig (qIn);
+  BOOST_CHECK (f.contains (qIn));
+  proj->rightHandSideFromConfig (qOut);
+  BOOST_CHECK (!f.contains (qIn));
+}
+
+BOOST_FIXTURE_TEST_CASE (EdgeSamplingWeights, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  StatePtr_t n1 (selector->createState ("node 1")),
+             n2 (selector->createState ("node 2"));
+  EdgePtr_t e11 (n1->linkTo ("edge 11", n1)),
+            e12 (n1->linkTo ("edge 12", n2));
+  graph->initialize ();
+
+  n1->updateWeight (e12, 3);
+  BOOST_CHECK_EQUAL (n1->getWeight (e12), 3);
+  BOOST_CHECK_EQUAL (n1->getWeight (e11), 1);
+
+  // Edge 12 is chosen three times out of four.
+  srand (0);
+  const int N (4000);
+  int n12 (0);
+  for (int i = 0; i < N; ++i)
+    if (n1->chooseEdge () == e12) ++n12;
+  BOOST_CHECK_CLOSE ((double)n12 / N, 0.75, 5);
+}
+
+BOOST_FIXTURE_TEST_CASE (DistancesToState, hpp_test::WaypointGraph)
+{
+  using namespace hpp_test;
+  typedef Graph::StateDistances_t StateDistances_t;
+
+  // A waypoint edge counts as many transitions as it contains. The
+  // transitions of negative weight are not followed.
+  initializeWaypointGraph (lockedJoint (0, 0.3));
+  StateDistances_t d (graph->distancesToState (n2));
+  BOOST_CHECK_EQUAL (d.size (), 2);
+  BOOST_CHECK_EQUAL (d[n2], 0);
+  BOOST_CHECK_EQUAL (d[n1], 2);
+  BOOST_CHECK (graph->distancesToState (n1).size () == 1);
+
+  GraphPtr_t other (Graph::create ("distances", robot, problem));
+  StateSelectorPtr_t otherSelector
+    (other->createStateSelector ("node-selector"));
+  StatePtr_t a (otherSelector->createState ("a")),
+             b (otherSelector->createState ("b")),
+             c (otherSelector->createState ("c")),
+             isolated (otherSelector->createState ("d"));
+  a->linkTo ("ab", b);
+  b->linkTo ("bc", c);
+  c->linkTo ("cc", c);
+  EdgePtr_t ac (a->linkTo ("ac", c, 0));
+  other->initialize ();
+
+  d = other->distancesToState (c);
+  BOOST_CHECK_EQUAL (d.size (), 3);
+  BOOST_CHECK_EQUAL (d[c], 0);
+  BOOST_CHECK_EQUAL (d[b], 1);
+  BOOST_CHECK_EQUAL (d[a], 2);
+  BOOST_CHECK (d.find (isolated) == d.end ());
+
+  // The shortest sequence of transitions is used.
+  a->updateWeight (ac, 1);
+  d = other->distancesToState (c);
+  BOOST_CHECK_EQUAL (d[a], 1);
+}
+
+BOOST_FIXTURE_TEST_CASE (ExtendBackward, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::PathPtr_t;
+  using hpp::core::ConfigurationPtr_t;
+  using hpp::manipulation::ManipulationPlanner;
+  using hpp::manipulation::ManipulationPlannerPtr_t;
+  using hpp::manipulation::Roadmap;
+  using hpp::manipulation::RoadmapPtr_t;
+  using hpp::manipulation::RoadmapNodePtr_t;
+  typedef hpp::manipulation::ConstraintSet ManipulationConstraintSet;
+  StatePtr_t n2 (selector->createState ("locked"));
+  n2->addNumericalConstraint (lockedJoint (0, 0.3));
+  StatePtr_t n1 (selector->createState ("free"));
+  EdgePtr_t e12 (n1->linkTo ("edge 12", n2)),
+            e22 (n2->linkTo ("edge 22", n2));
+  graph->initialize ();
+  problem->constraintGraph (graph);
+
+  RoadmapPtr_t roadmap (Roadmap::create (problem->distance (), robot));
+  roadmap->constraintGraph (graph);
+  ManipulationPlannerPtr_t planner (ManipulationPlanner::create (problem,
+        roadmap));
+  ConfigurationPtr_t q_near (new Configuration_t
+      (Configuration_t::Zero (6)));
+  (*q_near)[0] = 0.3;
+  RoadmapNodePtr_t near (static_cast <RoadmapNodePtr_t>
+      (roadmap->addNode (q_near)));
+  ConfigurationPtr_t q_rand (new Configuration_t (*q_near));
+  (*q_rand)[0] = 0.5;
+  (*q_rand)[2] = 0.2;
+
+  // Only the transitions starting from an allowed state are drawn. The path
+  // ends at the extended node, and starts in its leaf.
+  EdgePtr_t edges[] = { e22, e12 };
+  StatePtr_t from[] = { n2, n1 };
+  for (std::size_t i = 0; i < 2; ++i) {
+    planner->allowedStates (hpp::manipulation::graph::States_t (1, from[i]));
+    for (int j = 0; j < 5; ++j) {
+      PathPtr_t path;
+      BOOST_REQUIRE (planner->extendBackward (near, q_rand, path));
+      hpp::manipulation::ConstraintSetPtr_t c (HPP_DYNAMIC_PTR_CAST
+          (ManipulationConstraintSet, path->constraints ()));
+      BOOST_REQUIRE (c);
+      BOOST_CHECK (c->edge () == edges[i]);
+      BOOST_CHECK (path->end ().isApprox (*q_near, 1e-8));
+      BOOST_CHECK_CLOSE (path->initial ()[0], 0.3, 1e-6);
+      BOOST_CHECK (path->length () > 0);
+    }
+  }
+
+  // No transition leads to the free state.
+  PathPtr_t path;
+  ConfigurationPtr_t q_free (new Configuration_t
+      (Configuration_t::Zero (6)));
+  (*q_free)[0] = 0.1;
+  planner->allowedStates (hpp::manipulation::graph::States_t ());
+  BOOST_CHECK (!planner->extendBackward (static_cast <RoadmapNodePtr_t>
+        (roadmap->addNode (q_free)), q_rand, path));
+}
+
+BOOST_FIXTURE_TEST_CASE (ConnectLoopEdges, hpp_test::UR5Graph)
+{
+  using namespace hpp_test;
+  using hpp::core::Parameter;
+  using hpp::core::ConfigurationPtr_t;
+  using hpp::core::NodePtr_t;
+  using hpp::core::value_type;
+  using hpp::manipulation::ManipulationPlanner;
+  using hpp::manipulation::ManipulationPlannerPtr_t;
+  using hpp::manipulation::Roadmap;
+  using hpp::manipulation::RoadmapPtr_t;
+  StatePtr_t n1 (selector->createState ("free"));
+  n1->linkTo ("edge 11", n1);
+  graph->initialize ();
+  problem->constraintGraph (graph);
+  // Paths between configurations within the joint bounds are valid, so that
+  // the extensions always reach the random configuration.
+  problem->pathValidation (hpp::core::pathValidation::
+      createDiscretizedJointBound (robot, 0.05));
+  problem->setParameter ("ManipulationPlanner/connectLoopEdges",
+      Parameter (true));
+  problem->setParameter ("ManipulationPlanner/extendStep",
+      Parameter ((value_type)0.25));
+
+  RoadmapPtr_t roadmap (Roadmap::create (problem->distance (), robot));
+  roadmap->constraintGraph (graph);
+  roadmap->initNode (ConfigurationPtr_t (new Configuration_t
+        (Configuration_t::Zero (6))));
+  ManipulationPlannerPtr_t planner (ManipulationPlanner::create (problem,
+        roadmap));
+  planner->oneStep ();
+
+  // The extension is split in 4 nodes, each one linked to the previous one
+  // by a quarter of the path.
+  BOOST_REQUIRE_EQUAL (roadmap->nodes ().size (), 5);
+  std::vector <NodePtr_t> nodes (roadmap->nodes ().begin (),
+      roadmap->nodes ().end ());
+  value_type length (-1);
+  for (std::size_t i = 1; i < nodes.size (); ++i) {
+    BOOST_CHECK (nodes[i]->connectedComponent () ==
+        nodes[0]->connectedComponent ());
+    hpp::core::EdgePtr_t edge;
+    for (const hpp::core::EdgePtr_t& e : nodes[i - 1]->outEdges ())
+      if (e->to () == nodes[i]) { edge = e; break; }
+    BOOST_REQUIRE (edge);
+    BOOST_CHECK (edge->path ()->end ().isApprox
+        (*nodes[i]->configuration (), 1e-8));
+    if (length < 0) length = edge->path ()->length ();
+    BOOST_CHECK_CLOSE (edge->path ()->length (), length, 1e-6);
+  }
+}
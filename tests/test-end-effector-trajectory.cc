@@ -0,0 +1,264 @@
+// Copyright (c) 2020, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+#include <hpp/pinocchio/liegroup-element.hh>
+
+#include <hpp/constraints/differentiable-function.hh>
+#include <hpp/constraints/implicit.hh>
+
+#include <hpp/core/config-projector.hh>
+#include <hpp/core/config-validation.hh>
+#include <hpp/core/config-validations.hh>
+#include <hpp/core/constraint-set.hh>
+#include <hpp/core/node.hh>
+#include <hpp/core/problem.hh>
+#include <hpp/core/roadmap.hh>
+#include <hpp/core/path.hh>
+#include <hpp/core/straight-path.hh>
+
+#include <hpp/manipulation/path-planner/end-effector-trajectory.hh>
+#include <hpp/manipulation/steering-method/end-effector-trajectory.hh>
+
+#include <boost/test/unit_test.hpp>
+
+namespace hpp_test {
+  using hpp::core::Configuration_t;
+  using hpp::core::ConfigurationPtr_t;
+  using hpp::core::DevicePtr_t;
+  using hpp::core::LiegroupElementRef;
+  using hpp::core::LiegroupSpace;
+  using hpp::core::ProblemPtr_t;
+  using hpp::core::size_type;
+  using hpp::core::value_type;
+  using hpp::core::vector_t;
+  using hpp::core::vectorIn_t;
+  using hpp::core::matrixOut_t;
+  using hpp::constraints::ImplicitPtr_t;
+  using hpp::manipulation::pathPlanner::EndEffectorTrajectory;
+  using hpp::manipulation::pathPlanner::EndEffectorTrajectoryPtr_t;
+  typedef hpp::manipulation::steeringMethod::EndEffectorTrajectory
+    SteeringMethod;
+
+  /// Value of one configuration variable.
+  class VariableValue : public hpp::constraints::DifferentiableFunction
+  {
+    public:
+      VariableValue (const DevicePtr_t& robot, size_type index) :
+        DifferentiableFunction (robot->configSize (), robot->numberDof (),
+            LiegroupSpace::R1 (), "VariableValue"), index_ (index)
+      {}
+
+    protected:
+      void impl_compute (LiegroupElementRef result, vectorIn_t arg) const
+      {
+        result.vector ()[0] = arg[index_];
+      }
+
+      void impl_jacobian (matrixOut_t jacobian, vectorIn_t) const
+      {
+        jacobian.setZero ();
+        jacobian (0, index_) = 1;
+      }
+
+    private:
+      size_type index_;
+  };
+
+  /// Reject the configurations whose variable index is above a bound.
+  class RejectAbove : public hpp::core::ConfigValidation
+  {
+    public:
+      RejectAbove (size_type index, value_type bound) :
+        index_ (index), bound_ (bound)
+      {}
+
+      bool validate (const Configuration_t& config,
+          hpp::core::ValidationReportPtr_t&)
+      {
+        return config[index_] <= bound_;
+      }
+
+    private:
+      size_type index_;
+      value_type bound_;
+  };
+
+  DevicePtr_t robot;
+  ProblemPtr_t problem;
+
+  /// Build a problem where the first joint of a UR5 follows a straight
+  /// trajectory from 0 to 1.
+  EndEffectorTrajectoryPtr_t initialize (const Configuration_t& q_init)
+  {
+    robot = hpp::pinocchio::Device::create ("ur5");
+    hpp::pinocchio::urdf::loadModel
+      (robot, 0, "ur5/", "anchor",
+       "package://example-robot-data/robots/ur_description/urdf/"
+       "ur5_joint_limited_robot.urdf",
+       "package://example-robot-data/robots/ur_description/srdf/"
+       "ur5_joint_limited_robot.srdf");
+    problem = hpp::core::Problem::create (robot);
+
+    ImplicitPtr_t constraint (hpp::constraints::Implicit::create
+        (hpp::constraints::DifferentiableFunctionPtr_t
+         (new VariableValue (robot, 0)),
+         hpp::constraints::ComparisonTypes_t (1, hpp::constraints::Equality)));
+    hpp::core::ConfigProjectorPtr_t proj (hpp::core::ConfigProjector::create
+        (robot, "proj", 1e-4, 40));
+    proj->add (constraint);
+    hpp::core::ConstraintSetPtr_t set (hpp::core::ConstraintSet::create
+        (robot, "set"));
+    set->addConstraint (proj);
+
+    hpp::manipulation::steeringMethod::EndEffectorTrajectoryPtr_t sm
+      (SteeringMethod::create (problem));
+    sm->constraints (set);
+    sm->trajectoryConstraint (constraint);
+    sm->trajectory (hpp::core::StraightPath::create (LiegroupSpace::R1 (),
+          vector_t::Zero (1), vector_t::Ones (1),
+          hpp::core::interval_t (0, 1)), false);
+    problem->steeringMethod (sm);
+    problem->initConfig (ConfigurationPtr_t (new Configuration_t (q_init)));
+
+    EndEffectorTrajectoryPtr_t planner (EndEffectorTrajectory::create
+        (problem));
+    planner->nRandomConfig (0);
+    return planner;
+  }
+} // namespace hpp_test
+
+BOOST_AUTO_TEST_CASE (rejectAtFirstInvalidStep)
+{
+  using namespace hpp_test;
+  EndEffectorTrajectoryPtr_t planner (initialize
+      (Configuration_t::Zero (6)));
+  // The trajectory becomes invalid between 0.5 and 0.75.
+  problem->addConfigValidation (hpp::core::ConfigValidationPtr_t
+      (new RejectAbove (0, 0.6)));
+  planner->nDiscreteSteps (4);
+
+  planner->validateIntermediateConfigs (true);
+  planner->startSolve ();
+  planner->oneStep ();
+  BOOST_CHECK (planner->statistics ().nbSuccess () == 0);
+  BOOST_REQUIRE (planner->nbFailuresPerStep ().size () == 5);
+  BOOST_CHECK_EQUAL (planner->nbFailuresPerStep ()[3], 1);
+  BOOST_CHECK_EQUAL (planner->nbFailuresPerStep ()[4], 0);
+
+  // Without intermediate validation, the seed is only rejected at the end.
+  planner->validateIntermediateConfigs (false);
+  planner->startSolve ();
+  planner->oneStep ();
+  BOOST_CHECK (planner->statistics ().nbSuccess () == 0);
+  BOOST_REQUIRE (planner->nbFailuresPerStep ().size () == 5);
+  BOOST_CHECK_EQUAL (planner->nbFailuresPerStep ()[3], 0);
+  BOOST_CHECK_EQUAL (planner->nbFailuresPerStep ()[4], 1);
+}
+
+BOOST_AUTO_TEST_CASE (piecewiseLinearSE3Table)
+{
+  using namespace hpp_test;
+  using hpp::core::matrix_t;
+  using hpp::core::PathPtr_t;
+  using hpp::constraints::DifferentiableFunctionPtr_t;
+  initialize (Configuration_t::Zero (6));
+  hpp::manipulation::steeringMethod::EndEffectorTrajectoryPtr_t sm
+    (SteeringMethod::create (problem));
+
+  // Poses with distinct translations and rotations.
+  matrix_t points (4, 7);
+  points <<
+    0  , 0  , 0  , 0, 0, 0, 1,
+    1  , 0  , 0.5, 0, 0, 0.3826834, 0.9238795,
+    1  , 1  , 0.5, 0.5, 0.5, 0.5, 0.5,
+    0.5, 1.5, 0  , 0, 0.7071068, 0, 0.7071068;
+  points.rightCols (4).rowwise ().normalize ();
+  PathPtr_t path (SteeringMethod::makePiecewiseLinearTrajectory
+      (points, vector_t::Ones (6)));
+
+  sm->trajectory (path, true, false);
+  DifferentiableFunctionPtr_t fromPath (sm->trajectory ());
+  sm->trajectory (path, true, true);
+  DifferentiableFunctionPtr_t fromTable (sm->trajectory ());
+  BOOST_REQUIRE (fromPath != fromTable);
+
+  const value_type t0 (path->timeRange ().first),
+        t1 (path->timeRange ().second);
+  matrix_t Jpath (6, 1), Jtable (6, 1);
+  for (int i = 0; i <= 100; ++i) {
+    vector_t t (vector_t::Constant (1, t0 + (t1 - t0) * i / 100.));
+    BOOST_CHECK ((*fromTable) (t).vector ().isApprox
+        ((*fromPath) (t).vector (), 1e-8));
+    fromPath->jacobian (Jpath, t);
+    fromTable->jacobian (Jtable, t);
+    BOOST_CHECK (Jtable.isApprox (Jpath, 1e-8));
+  }
+}
+
+namespace hpp_test {
+  /// IK solver that finds no solution.
+  class NoIkSolution :
+    public hpp::manipulation::pathPlanner::IkSolverInitialization
+  {
+    protected:
+      Configurations_t impl_solve (vectorIn_t)
+      {
+        return Configurations_t ();
+      }
+  };
+} // namespace hpp_test
+
+BOOST_AUTO_TEST_CASE (reuseStoredSolution)
+{
+  using namespace hpp_test;
+  using hpp::manipulation::pathPlanner::SolutionMemory;
+  using hpp::manipulation::pathPlanner::SolutionMemoryPtr_t;
+  using hpp::manipulation::pathPlanner::IkSolverInitializationPtr_t;
+  using hpp::pinocchio::LiegroupElement;
+
+  // The initial configuration is invalid, so a solution is found only from
+  // the stored one.
+  Configuration_t q_init (Configuration_t::Zero (6)),
+                  q_stored (Configuration_t::Zero (6));
+  q_init[1] = 1;
+  q_stored[2] = 0.1;
+  SolutionMemoryPtr_t memory (SolutionMemory::create ());
+  memory->add (LiegroupElement (vector_t::Zero (1), LiegroupSpace::R1 ()),
+      q_stored);
+
+  for (int useIk = 0; useIk < 2; ++useIk) {
+    EndEffectorTrajectoryPtr_t planner (initialize (q_init));
+    problem->addConfigValidation (hpp::core::ConfigValidationPtr_t
+        (new RejectAbove (1, 0.5)));
+    if (useIk)
+      planner->ikSolverInitialization (IkSolverInitializationPtr_t
+          (new NoIkSolution));
+
+    planner->startSolve ();
+    planner->oneStep ();
+    BOOST_CHECK (planner->statistics ().nbSuccess () == 0);
+
+    planner->solutionMemory (memory);
+    planner->startSolve ();
+    planner->oneStep ();
+    BOOST_CHECK (planner->statistics ().nbSuccess () == 1);
+    BOOST_REQUIRE (planner->roadmap ()->initNode ());
+    BOOST_CHECK_CLOSE ((*planner->roadmap ()->initNode ()->configuration ())[2],
+        0.1, 1e-6);
+  }
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2020, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <pinocchio/multibody/model.hpp>
+
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/manipulation/device.hh>
+#include <hpp/manipulation/graph/graph.hh>
+#include <hpp/manipulation/weighed-distance.hh>
+
+#include <boost/test/unit_test.hpp>
+
+namespace hpp_test {
+  using hpp::core::Configuration_t;
+  using hpp::core::matrix_t;
+  using hpp::core::size_type;
+  using hpp::core::vector_t;
+  using hpp::manipulation::DevicePtr_t;
+
+  /// Two UR5, on a free-flyer and on a planar joint.
+  DevicePtr_t createRobot ()
+  {
+    DevicePtr_t robot (hpp::manipulation::Device::create ("two-ur5"));
+    hpp::pinocchio::urdf::loadModel
+      (robot, 0, "ur5a/", "freeflyer",
+       "package://example-robot-data/robots/ur_description/urdf/"
+       "ur5_joint_limited_robot.urdf",
+       "package://example-robot-data/robots/ur_description/srdf/"
+       "ur5_joint_limited_robot.srdf");
+    hpp::pinocchio::urdf::loadModel
+      (robot, 0, "ur5b/", "planar",
+       "package://example-robot-data/robots/ur_description/urdf/"
+       "ur5_joint_limited_robot.urdf",
+       "package://example-robot-data/robots/ur_description/srdf/"
+       "ur5_joint_limited_robot.srdf");
+    return robot;
+  }
+
+  /// Random configuration with normalized rotations.
+  Configuration_t randomConfig (const DevicePtr_t& robot)
+  {
+    const hpp::pinocchio::Model& model (robot->model ());
+    Configuration_t q (Configuration_t::Random (robot->configSize ()));
+    for (std::size_t i = 1; i < model.joints.size (); ++i) {
+      size_type r (model.joints[i].idx_q ()), n (model.joints[i].nq ());
+      if (n == 7) q.segment (r + 3, 4).normalize ();
+      else if (n == 4) q.segment (r + 2, 2).normalize ();
+    }
+    return q;
+  }
+} // namespace hpp_test
+
+BOOST_AUTO_TEST_CASE (batchDistances)
+{
+  using namespace hpp_test;
+  using hpp::manipulation::WeighedDistance;
+  using hpp::manipulation::WeighedDistancePtr_t;
+  DevicePtr_t robot (createRobot ());
+  WeighedDistancePtr_t distance (WeighedDistance::create (robot,
+        hpp::manipulation::graph::GraphPtr_t ()));
+
+  Configuration_t q (randomConfig (robot));
+  const size_type n (50);
+  matrix_t configs (q.size (), n);
+  for (size_type i = 0; i < n; ++i)
+    configs.col (i) = randomConfig (robot);
+  // Opposite quaternions represent the same rotation.
+  configs.col (0) = q;
+  configs.col (0).segment (3, 4) *= -1;
+  // Rotations close to q.
+  configs.col (1) = q;
+  configs.col (1).segment (3, 4) += 1e-3 * vector_t::Ones (4);
+  configs.col (1).segment (3, 4).normalize ();
+
+  vector_t result (n);
+  distance->distances (q, configs, result);
+  for (size_type i = 0; i < n; ++i)
+    BOOST_CHECK_SMALL (result[i] - (*distance) (q, configs.col (i)), 1e-6);
+  BOOST_CHECK_SMALL (result[0], 1e-8);
+  BOOST_CHECK (result.tail (n - 2).minCoeff () > 1e-3);
+}